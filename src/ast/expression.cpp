@@ -86,6 +86,57 @@ namespace lorraine::ast
         }
     }
 
+    std::string binary_expression::to_string( binary_operator op )
+    {
+        switch ( op )
+        {
+            case binary_operator::add: return "+";
+            case binary_operator::subtract: return "-";
+            case binary_operator::multiply: return "*";
+            case binary_operator::divide: return "/";
+            case binary_operator::modulo: return "%";
+            case binary_operator::power: return "^";
+            case binary_operator::concat: return "..";
+            case binary_operator::equal: return "==";
+            case binary_operator::not_equal: return "~=";
+            case binary_operator::less: return "<";
+            case binary_operator::less_equal: return "<=";
+            case binary_operator::greater: return ">";
+            case binary_operator::greater_equal: return ">=";
+            case binary_operator::logical_and: return "and";
+            case binary_operator::logical_or: return "or";
+        }
+
+        return {};
+    }
+
+    void binary_expression::visit( visitor* v )
+    {
+        if ( v->visit( this ) )
+        {
+            left->visit( v );
+            right->visit( v );
+        }
+    }
+
+    std::string unary_expression::to_string( unary_operator op )
+    {
+        switch ( op )
+        {
+            case unary_operator::negate: return "-";
+            case unary_operator::logical_not: return "not";
+            case unary_operator::length: return "#";
+        }
+
+        return {};
+    }
+
+    void unary_expression::visit( visitor* v )
+    {
+        if ( v->visit( this ) )
+            value->visit( v );
+    }
+
     void variable_assignment::visit( visitor* v )
     {
         if ( v->visit( this ) )
@@ -27,9 +27,13 @@ namespace lorraine::ast
     {
         double value;
 
-        explicit number_literal( const utils::location& location, double value )
+        /// @brief Written as an integer (see lexer::token::integer)
+        bool integer;
+
+        explicit number_literal( const utils::location& location, double value, bool integer = false )
             : expression( location ),
-              value( value )
+              value( value ),
+              integer( integer )
         {
             type = std::make_shared< type::type >( type::type::primitive_type::number );
         }
@@ -148,6 +152,7 @@ namespace lorraine::ast
             : expression( location ),
               var( var )
         {
+            type = this->var->type;
         }
 
         void visit( visitor* v ) override;
@@ -281,6 +286,85 @@ namespace lorraine::ast
         void visit( visitor* v ) override;
     };
 
+    enum class binary_operator
+    {
+        // Arithmetic
+        add,
+        subtract,
+        multiply,
+        divide,
+        modulo,
+        power,
+
+        concat,
+
+        // Comparison
+        equal,
+        not_equal,
+        less,
+        less_equal,
+        greater,
+        greater_equal,
+
+        // Logical
+        logical_and,
+        logical_or,
+    };
+
+    enum class unary_operator
+    {
+        negate,
+        logical_not,
+        length,
+    };
+
+    /// @brief An operation on two expressions, e.g. `a + b`
+    struct binary_expression : expression
+    {
+        binary_operator op;
+        std::unique_ptr< expression > left;
+        std::unique_ptr< expression > right;
+
+        explicit binary_expression(
+            const utils::location& location,
+            binary_operator op,
+            std::unique_ptr< expression > left,
+            std::unique_ptr< expression > right )
+            : expression( location ),
+              op( op ),
+              left( std::move( left ) ),
+              right( std::move( right ) )
+        {
+        }
+
+        /// @brief Returns the symbol of the operator provided, as it is written in the source
+        static std::string to_string( binary_operator op );
+
+        void visit( visitor* v ) override;
+    };
+
+    /// @brief An operation on one expression, e.g. `-a`
+    struct unary_expression : expression
+    {
+        unary_operator op;
+        std::unique_ptr< expression > value;
+
+        explicit unary_expression(
+            const utils::location& location,
+            unary_operator op,
+            std::unique_ptr< expression > value )
+            : expression( location ),
+              op( op ),
+              value( std::move( value ) )
+        {
+        }
+
+        /// @brief Returns the symbol of the operator provided, as it is written in the source
+        static std::string to_string( unary_operator op );
+
+        void visit( visitor* v ) override;
+    };
+
     struct variable_assignment : expression
     {
         std::shared_ptr< variable > var;
@@ -0,0 +1,364 @@
+#include "folder.hpp"
+
+#include <cmath>
+#include <optional>
+
+namespace lorraine::ast
+{
+    namespace
+    {
+        bool is_literal( const expression* node )
+        {
+            return dynamic_cast< const number_literal* >( node ) || dynamic_cast< const string_literal* >( node ) ||
+                   dynamic_cast< const boolean_literal* >( node ) || dynamic_cast< const nil_literal* >( node );
+        }
+
+        /// @brief Copies a literal to another location
+        std::unique_ptr< expression > copy_literal( const expression& literal, const utils::location& location )
+        {
+            if ( const auto number = dynamic_cast< const number_literal* >( &literal ) )
+                return std::make_unique< number_literal >( location, number->value, number->integer );
+
+            if ( const auto string = dynamic_cast< const string_literal* >( &literal ) )
+                return std::make_unique< string_literal >( location, string->value );
+
+            if ( const auto boolean = dynamic_cast< const boolean_literal* >( &literal ) )
+                return std::make_unique< boolean_literal >( location, boolean->value );
+
+            return std::make_unique< nil_literal >( location );
+        }
+
+        /// @brief Checks if a literal counts as true in a condition, everything except nil and false does
+        bool is_truthy( const expression& literal )
+        {
+            if ( const auto boolean = dynamic_cast< const boolean_literal* >( &literal ) )
+                return boolean->value;
+
+            return !dynamic_cast< const nil_literal* >( &literal );
+        }
+
+        bool is_equal( const expression& a, const expression& b )
+        {
+            const auto a_number = dynamic_cast< const number_literal* >( &a );
+            const auto b_number = dynamic_cast< const number_literal* >( &b );
+
+            if ( a_number || b_number )
+                return a_number && b_number && a_number->value == b_number->value;
+
+            const auto a_string = dynamic_cast< const string_literal* >( &a );
+            const auto b_string = dynamic_cast< const string_literal* >( &b );
+
+            if ( a_string || b_string )
+                return a_string && b_string && a_string->value == b_string->value;
+
+            const auto a_boolean = dynamic_cast< const boolean_literal* >( &a );
+            const auto b_boolean = dynamic_cast< const boolean_literal* >( &b );
+
+            if ( a_boolean || b_boolean )
+                return a_boolean && b_boolean && a_boolean->value == b_boolean->value;
+
+            // Both are nil
+            return true;
+        }
+
+        /// @brief Creates the number an operation results in. It stays an integer if it was computed from integers and
+        /// is one. Negative zero is not.
+        std::unique_ptr< expression > make_number( const utils::location& location, double value, bool integer )
+        {
+            integer = integer && std::trunc( value ) == value && value >= -0x1p63 && value < 0x1p63 &&
+                      !( value == 0 && std::signbit( value ) );
+
+            return std::make_unique< number_literal >( location, value, integer );
+        }
+
+        /// @brief The modulo of Lua, it has the sign of the divisor
+        double modulo( double a, double b )
+        {
+            double m = std::fmod( a, b );
+
+            if ( m > 0 ? b < 0 : ( m < 0 && b != m ) )
+                m += b;
+
+            return m;
+        }
+
+        /// @brief Compares two literals of the same type, numbers by value and strings by their bytes
+        /// @return Negative, zero or positive, like std::string::compare. Nothing if they cannot be compared (NaN).
+        std::optional< int > compare( const expression& a, const expression& b )
+        {
+            const auto a_number = dynamic_cast< const number_literal* >( &a );
+            const auto b_number = dynamic_cast< const number_literal* >( &b );
+
+            if ( a_number && b_number )
+            {
+                if ( std::isnan( a_number->value ) || std::isnan( b_number->value ) )
+                    return std::nullopt;
+
+                return ( a_number->value > b_number->value ) - ( a_number->value < b_number->value );
+            }
+
+            const auto a_string = dynamic_cast< const string_literal* >( &a );
+            const auto b_string = dynamic_cast< const string_literal* >( &b );
+
+            if ( a_string && b_string )
+                return a_string->value.compare( b_string->value );
+
+            return std::nullopt;
+        }
+
+        /// @brief Evaluates a binary operation on two literals
+        /// @return The value, nullptr if the operation cannot be evaluated at compile time
+        std::unique_ptr< expression > evaluate( const binary_expression& node )
+        {
+            const auto& left = *node.left;
+            const auto& right = *node.right;
+
+            switch ( node.op )
+            {
+                case binary_operator::equal:
+                    return std::make_unique< boolean_literal >( node.location, is_equal( left, right ) );
+                case binary_operator::not_equal:
+                    return std::make_unique< boolean_literal >( node.location, !is_equal( left, right ) );
+
+                case binary_operator::less:
+                case binary_operator::less_equal:
+                case binary_operator::greater:
+                case binary_operator::greater_equal:
+                {
+                    const auto order = compare( left, right );
+
+                    if ( !order && !( dynamic_cast< const number_literal* >( &left ) &&
+                                      dynamic_cast< const number_literal* >( &right ) ) )
+                        return nullptr;
+
+                    // Every comparison with NaN is false
+                    bool value = false;
+
+                    if ( order )
+                    {
+                        switch ( node.op )
+                        {
+                            case binary_operator::less: value = *order < 0; break;
+                            case binary_operator::less_equal: value = *order <= 0; break;
+                            case binary_operator::greater: value = *order > 0; break;
+                            default: value = *order >= 0; break;
+                        }
+                    }
+
+                    return std::make_unique< boolean_literal >( node.location, value );
+                }
+
+                case binary_operator::concat:
+                {
+                    const auto a = dynamic_cast< const string_literal* >( &left );
+                    const auto b = dynamic_cast< const string_literal* >( &right );
+
+                    if ( !a || !b )
+                        return nullptr;
+
+                    return std::make_unique< string_literal >( node.location, a->value + b->value );
+                }
+
+                default: break;
+            }
+
+            // Arithmetic
+            const auto a = dynamic_cast< const number_literal* >( &left );
+            const auto b = dynamic_cast< const number_literal* >( &right );
+
+            if ( !a || !b )
+                return nullptr;
+
+            const bool integer = a->integer && b->integer;
+
+            switch ( node.op )
+            {
+                case binary_operator::add: return make_number( node.location, a->value + b->value, integer );
+                case binary_operator::subtract: return make_number( node.location, a->value - b->value, integer );
+                case binary_operator::multiply: return make_number( node.location, a->value * b->value, integer );
+                case binary_operator::divide: return make_number( node.location, a->value / b->value, false );
+                case binary_operator::modulo:
+                    return make_number( node.location, modulo( a->value, b->value ), integer );
+                case binary_operator::power:
+                    return make_number( node.location, std::pow( a->value, b->value ), false );
+                default: return nullptr;
+            }
+        }
+
+        /// @brief Evaluates a unary operation on a literal
+        /// @return The value, nullptr if the operation cannot be evaluated at compile time
+        std::unique_ptr< expression > evaluate( const unary_expression& node )
+        {
+            const auto& value = *node.value;
+
+            switch ( node.op )
+            {
+                case unary_operator::negate:
+                {
+                    if ( const auto number = dynamic_cast< const number_literal* >( &value ) )
+                    {
+                        // Like doubles, the negation of zero is negative zero
+                        return make_number( node.location, -number->value, number->integer );
+                    }
+
+                    return nullptr;
+                }
+                case unary_operator::logical_not:
+                    return std::make_unique< boolean_literal >( node.location, !is_truthy( value ) );
+                case unary_operator::length:
+                {
+                    if ( const auto string = dynamic_cast< const string_literal* >( &value ) )
+                        return make_number( node.location, static_cast< double >( string->value.size() ), true );
+
+                    return nullptr;
+                }
+            }
+
+            return nullptr;
+        }
+    }  // namespace
+
+    void folder::fold( module* root )
+    {
+        folder f;
+        root->visit( &f );
+    }
+
+    void folder::fold( statement* node )
+    {
+        node->visit( this );
+    }
+
+    void folder::fold( std::unique_ptr< expression >& expression )
+    {
+        expression->visit( this );
+
+        if ( replacement )
+            expression = std::move( replacement );
+    }
+
+    bool folder::visit( expression_statement* node )
+    {
+        fold( node->expr );
+        return false;
+    }
+
+    bool folder::visit( local_assignment* node )
+    {
+        for ( auto& value : node->values )
+            fold( value );
+
+        // The names only refer to the new variables after the assignment
+        for ( std::size_t i = 0; i < node->variables.size(); ++i )
+        {
+            const auto& name = node->variables[ i ]->value;
+
+            if ( node->constant && i < node->values.size() && is_literal( node->values[ i ].get() ) )
+                constants[ name ] = copy_literal( *node->values[ i ], node->values[ i ]->location );
+            else
+                constants.erase( name );
+        }
+
+        return false;
+    }
+
+    bool folder::visit( import* node )
+    {
+        // Imported modules are compiled on their own
+        return false;
+    }
+
+    bool folder::visit( variable_reference* node )
+    {
+        const auto it = constants.find( node->var->value );
+
+        if ( it != constants.end() )
+            replacement = copy_literal( *it->second, node->location );
+
+        return false;
+    }
+
+    bool folder::visit( call* node )
+    {
+        fold( node->function );
+
+        for ( auto& argument : node->arguments )
+            fold( argument );
+
+        return false;
+    }
+
+    bool folder::visit( name_index* node )
+    {
+        fold( node->variable );
+        return false;
+    }
+
+    bool folder::visit( expression_index* node )
+    {
+        fold( node->variable );
+        fold( node->index );
+
+        return false;
+    }
+
+    bool folder::visit( expression_group* node )
+    {
+        fold( node->value );
+
+        if ( is_literal( node->value.get() ) )
+            replacement = copy_literal( *node->value, node->location );
+
+        return false;
+    }
+
+    bool folder::visit( list_constructor* node )
+    {
+        for ( auto& element : node->expressions )
+        {
+            // Not part of the visitor, the values of table constructors are folded on their own
+            if ( const auto assignment = dynamic_cast< variable_assignment* >( element.get() ) )
+                fold( assignment->value );
+            else
+                fold( element );
+        }
+
+        return false;
+    }
+
+    bool folder::visit( binary_expression* node )
+    {
+        fold( node->left );
+
+        // The right operand of 'and' and 'or' is only evaluated if the left one does not decide the result
+        if ( node->op == binary_operator::logical_and || node->op == binary_operator::logical_or )
+        {
+            fold( node->right );
+
+            if ( is_literal( node->left.get() ) )
+            {
+                const bool left = is_truthy( *node->left ) == ( node->op == binary_operator::logical_or );
+                replacement = std::move( left ? node->left : node->right );
+            }
+
+            return false;
+        }
+
+        fold( node->right );
+
+        if ( is_literal( node->left.get() ) && is_literal( node->right.get() ) )
+            replacement = evaluate( *node );
+
+        return false;
+    }
+
+    bool folder::visit( unary_expression* node )
+    {
+        fold( node->value );
+
+        if ( is_literal( node->value.get() ) )
+            replacement = evaluate( *node );
+
+        return false;
+    }
+}  // namespace lorraine::ast
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "visitor.hpp"
+
+namespace lorraine::ast
+{
+    /// @brief Evaluates operations on literals at compile time and replaces references to `local const` variables by
+    /// their values, if these are literals. Runs on validated modules: the operands of every operation have types
+    /// that fit the operator, so every operation on literals has a value.
+    class folder final : public visitor
+    {
+       public:
+        /// @brief Folds all top-level statements of a module. Imported modules are left alone.
+        /// @param root The module
+        static void fold( module* root );
+
+        /// @brief Folds a top-level statement of a module that is compiled one statement at a time. The values of the
+        /// constants it declares are kept for the statements after it.
+        /// @param node The statement
+        void fold( statement* node );
+
+        bool visit( expression_statement* node ) override;
+        bool visit( local_assignment* node ) override;
+        bool visit( import* node ) override;
+
+        bool visit( variable_reference* node ) override;
+        bool visit( call* node ) override;
+        bool visit( name_index* node ) override;
+        bool visit( expression_index* node ) override;
+        bool visit( expression_group* node ) override;
+        bool visit( list_constructor* node ) override;
+        bool visit( binary_expression* node ) override;
+        bool visit( unary_expression* node ) override;
+
+       private:
+        /// @brief Values of the constants in scope, by name
+        std::unordered_map< std::string, std::unique_ptr< expression > > constants;
+
+        /// @brief Literal that replaces the expression that was visited last
+        std::unique_ptr< expression > replacement;
+
+        /// @brief Folds an expression and everything in it, replacing it if it has a constant value
+        /// @param expression The expression
+        void fold( std::unique_ptr< expression >& expression );
+    };
+}  // namespace lorraine::ast
@@ -23,7 +23,7 @@ namespace lorraine::ast
 
     std::shared_ptr< type::type > block::get_type( const std::string_view& name )
     {
-        const auto it = types.find( name );
+        const auto it = types.find( std::string{ name } );
 
         if ( it == types.end() )
             if ( parent )
@@ -85,7 +85,7 @@ namespace lorraine::ast
 
     std::shared_ptr< type::type > block::get_variable_type( const std::string_view& name )
     {
-        const auto it = variables.find( name );
+        const auto it = variables.find( std::string{ name } );
 
         if ( it == variables.end() )
             if ( parent )
@@ -146,8 +146,20 @@ namespace lorraine::ast
     {
         std::shared_ptr< module::information > info = std::make_shared< module::information >();
 
-        // Absolute path to our module
-        std::filesystem::path absolute = utils::system::get_source_dir().append( name + ".lua" );
+        // Local modules ('./' or '../') are resolved relative to the module that imports them, everything else is a
+        // library module that ships with the compiler.
+        std::filesystem::path absolute;
+
+        if ( name.rfind( "./", 0 ) == 0 || name.rfind( "../", 0 ) == 0 )
+        {
+            const std::filesystem::path base = relative && relative->name != "stdin"
+                                                   ? std::filesystem::path{ relative->absolute() }.parent_path()
+                                                   : utils::system::get_working_dir();
+
+            absolute = ( base / ( name + ".lua" ) ).lexically_normal();
+        }
+        else
+            absolute = utils::system::get_source_dir().append( name + ".lua" );
 
         info->name = name;
         info->filename = absolute.filename();
@@ -37,12 +37,13 @@ namespace lorraine::ast
 
     struct block : statement
     {
-        block* parent;
+        block* parent = nullptr;
         statement_list body;
 
-        // Data structures for the block's content
-        std::unordered_map< std::string_view, std::shared_ptr< type::type > > variables;
-        std::unordered_map< std::string_view, std::shared_ptr< type::type > > types;
+        // Data structures for the block's content. The names are owned by the scope, as the statements that
+        // declared them may be discarded before the block (see parser::parse_statements).
+        std::unordered_map< std::string, std::shared_ptr< type::type > > variables;
+        std::unordered_map< std::string, std::shared_ptr< type::type > > types;
 
         // Exportable data types
         std::unordered_map< std::string, std::shared_ptr< type::type > > export_variables;
@@ -74,10 +75,18 @@ namespace lorraine::ast
         variable_list variables;
         expression_list values;
 
-        explicit local_assignment( const utils::location& location, variable_list variables, expression_list values )
+        /// @brief Declared with `local const`, the variables keep their values
+        bool constant;
+
+        explicit local_assignment(
+            const utils::location& location,
+            variable_list variables,
+            expression_list values,
+            bool constant = false )
             : statement( location ),
               variables( std::move( variables ) ),
-              values( std::move( values ) )
+              values( std::move( values ) ),
+              constant( constant )
 
         {
         }
@@ -109,6 +118,9 @@ namespace lorraine::ast
             std::string directory, filename, name;
             std::string_view source;
 
+            /// @brief Owns the source of modules that were read by the compiler itself (e.g. imports)
+            std::string buffer;
+
             std::string absolute() const;
 
             static std::shared_ptr< information > get( const std::string& path, std::string_view source );
@@ -134,12 +146,14 @@ namespace lorraine::ast
     struct import : statement
     {
         expression_list name_list;
-        std::unique_ptr< ast::module > module;
+
+        /// @brief The imported module, shared by all modules that import it (see parser::get_module)
+        std::shared_ptr< ast::module > module;
 
         explicit import(
             const utils::location& location,
             expression_list name_list,
-            std::unique_ptr< ast::module > module )
+            std::shared_ptr< ast::module > module )
             : statement( location ),
               name_list( std::move( name_list ) ),
               module( std::move( module ) )
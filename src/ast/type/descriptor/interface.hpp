@@ -23,6 +23,10 @@ namespace lorraine::ast::type
             generic_list generics;
             std::string name;
 
+            // Types given for the generic types where the interface is used, like 'Array<number>'. Empty if they
+            // are not given, then values with any types for them fit.
+            std::vector< std::shared_ptr< type > > arguments;
+
             struct property
             {
                 std::string name;
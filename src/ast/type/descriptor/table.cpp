@@ -1,5 +1,7 @@
 #include "table.hpp"
 
+#include <algorithm>
+#include <numeric>
 #include <sstream>
 
 #include "../type.hpp"
@@ -8,7 +10,7 @@ namespace lorraine::ast::type::descriptor
 {
     bool table::table_property::is( table::table_property property ) const
     {
-        return property.name == name && property.t->is( t );
+        return property.name == name && t->is( property.t );
     }
 
     std::string table::to_string() const
@@ -34,4 +36,46 @@ namespace lorraine::ast::type::descriptor
 
         return std::nullopt;
     }
-}  // namespace lorraine::ast::type::descriptor
\ No newline at end of file
+
+    std::optional< std::size_t > table::get_index( const std::string& name ) const
+    {
+        for ( std::size_t i = 0; i < properties.size(); ++i )
+        {
+            if ( properties[ i ].name == name )
+                return i;
+        }
+
+        return std::nullopt;
+    }
+
+    table::layout table::get_layout() const
+    {
+        layout result;
+
+        result.fields.resize( properties.size() );
+        std::iota( result.fields.begin(), result.fields.end(), 0 );
+
+        // Booleans are stored in a byte, every other value (numbers, pointers, boxes and arrays) is aligned to 8 bytes
+        const auto alignment = [ this ]( std::size_t i )
+        { return properties[ i ].t->is( type::primitive_type::boolean ) ? 1 : 8; };
+
+        std::stable_sort(
+            result.fields.begin(),
+            result.fields.end(),
+            [ & ]( std::size_t a, std::size_t b ) { return alignment( a ) > alignment( b ); } );
+
+        result.field_of.resize( properties.size() );
+        result.bit_of.resize( properties.size() );
+
+        for ( std::size_t field = 0; field < result.fields.size(); ++field )
+            result.field_of[ result.fields[ field ] ] = field;
+
+        for ( std::size_t i = 0; i < properties.size(); ++i )
+        {
+            if ( properties[ i ].is_optional )
+                result.bit_of[ i ] = result.optional_count++;
+        }
+
+        return result;
+    }
+}  // namespace lorraine::ast::type::descriptor
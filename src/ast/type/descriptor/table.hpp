@@ -34,12 +34,30 @@ namespace lorraine::ast::type
                 {
                 }
 
-                /// @brief Compares the current table property with another
-                /// @param property Table property
-                /// @return True if equal
+                /// @brief Compares the current table property with another, like type::is
+                /// @param property Table property of the value
+                /// @return True if the property of the value fits in this one
                 bool is( table_property property ) const;
             };
 
+            /// @brief Where the properties are in the struct the table is lowered to (see type::to_llvm_type). The
+            /// fields are ordered by their alignment, largest first, so that there is no padding between them. Optional
+            /// properties have a bit in a mask after the fields, which is set if they are present.
+            struct layout
+            {
+                /// @brief Index of the property in each field
+                std::vector< std::size_t > fields;
+
+                /// @brief Field of each property
+                std::vector< std::size_t > field_of;
+
+                /// @brief Bit in the mask of each property, if it is optional
+                std::vector< std::optional< std::size_t > > bit_of;
+
+                /// @brief Number of optional properties, the mask has a byte for every 8 of them
+                std::size_t optional_count = 0;
+            };
+
             /// @brief Returns a string representation of the table descriptor
             /// @return New string representation
             std::string to_string() const;
@@ -48,6 +66,13 @@ namespace lorraine::ast::type
             /// @return The property
             std::optional< table_property > get_property( const std::string& name );
 
+            /// @brief Gets the index of a property by name
+            /// @return The index or nothing if there is no such property
+            std::optional< std::size_t > get_index( const std::string& name ) const;
+
+            /// @brief Gets the layout of the struct the table is lowered to
+            layout get_layout() const;
+
             std::vector< table_property > properties;
         };
     }  // namespace descriptor
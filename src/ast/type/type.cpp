@@ -83,6 +83,11 @@ namespace lorraine::ast::type
         if ( const auto array = std::get_if< descriptor::array >( &value ) )
             return array->t->is( t.t );
 
+        // Arrays implement the Array interface (see lib/array.lua)
+        if ( const auto interface = std::get_if< descriptor::interface >( &value ) )
+            return interface->name == "Array" &&
+                   ( interface->arguments.empty() || interface->arguments.front()->is( t.t ) );
+
         return false;
     }
 
@@ -96,6 +101,14 @@ namespace lorraine::ast::type
             if ( interface->generics.size() != t.generics.size() )
                 return false;
 
+            // Only types given for the generic types on both sides are compared
+            if ( !interface->arguments.empty() && !t.arguments.empty() )
+            {
+                for ( std::size_t i = 0; i < interface->arguments.size(); ++i )
+                    if ( !interface->arguments[ i ]->is( t.arguments[ i ] ) )
+                        return false;
+            }
+
             return true;
         }
 
@@ -104,6 +117,12 @@ namespace lorraine::ast::type
 
     bool type::is( std::shared_ptr< type > t )
     {
+        // Any value fits where a value of type any is expected, it is boxed there. The other way around is not a
+        // relation of the types, a value of type any is taken out of its box where a primitive is expected (see
+        // is_assignable in validator.cpp).
+        if ( is( primitive_type::any ) )
+            return true;
+
         if ( const auto prim = std::get_if< primitive_type >( &t->value ) )
             return is( *prim );
 
@@ -180,6 +199,16 @@ namespace lorraine::ast::type
                 case primitive_type::boolean: return llvm::Type::getInt1Ty( context );
                 case primitive_type::string: return llvm::PointerType::getUnqual( llvm::Type::getInt8Ty( context ) );
 
+                // Values of any type are NaN-boxed (see code_generation::box). The 64 bits are wrapped in a named
+                // struct, so that boxes are not mistaken for integers.
+                case primitive_type::any:
+                {
+                    if ( const auto box = llvm::StructType::getTypeByName( context, "any" ) )
+                        return box;
+
+                    return llvm::StructType::create( context, { llvm::Type::getInt64Ty( context ) }, "any" );
+                }
+
                 default:
                     throw utils::compiler_error(
                         "An LLVM Type does not exist for the provided Lua++ primitive '" + to_string() + "'" );
@@ -224,6 +253,41 @@ namespace lorraine::ast::type
 
             return llvm::FunctionType::get( return_type, llvm::makeArrayRef( argument_types ), is_vararg );
         }
+        else if ( const auto array = std::get_if< descriptor::array >( &value ) )
+        {
+            // Arrays are passed by value: their length, their capacity and a pointer to their elements. A capacity of
+            // zero means the elements are read-only (the static data of a constant constructor) and are copied before
+            // the array is changed.
+            llvm::Type *size = llvm::Type::getInt64Ty( context );
+
+            return llvm::StructType::get( context, { size, size, array->t->to_llvm_type( context )->getPointerTo() } );
+        }
+        else if ( const auto table = std::get_if< descriptor::table >( &value ) )
+        {
+            // Tables are pointers to a structure of their properties, so that a property is at a constant offset.
+            // The shape of the table comes first, for accesses through values of type any (see
+            // code_generation::get_dynamic_property). The mask of the optional properties that are present comes
+            // after the properties (see descriptor::table::layout).
+            const auto layout = table->get_layout();
+            std::vector< llvm::Type * > field_types = { llvm::Type::getInt8PtrTy( context ) };
+
+            for ( const auto property : layout.fields )
+                field_types.push_back( table->properties[ property ].t->to_llvm_type( context ) );
+
+            if ( layout.optional_count > 0 )
+                field_types.push_back(
+                    llvm::ArrayType::get( llvm::Type::getInt8Ty( context ), ( layout.optional_count + 7 ) / 8 ) );
+
+            return llvm::StructType::get( context, field_types )->getPointerTo();
+        }
+        else if ( std::holds_alternative< descriptor::interface >( value ) )
+        {
+            // Values of an interface type are pointers to the value that implements it and to the table of its
+            // members, the itable (see code_generation::create_interface)
+            llvm::Type *pointer = llvm::Type::getInt8PtrTy( context );
+
+            return llvm::StructType::get( context, { pointer, pointer->getPointerTo() } );
+        }
         else
             throw utils::compiler_error( "Unsupported Lua++ type" );
 
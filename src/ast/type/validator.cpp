@@ -2,7 +2,45 @@
 
 namespace lorraine::ast::type
 {
+    namespace
+    {
+        /// @brief Checks if the type of an operand is not known to be anything else than a primitive, e.g. the result
+        /// of a call or a value of type any
+        bool is_unknown( const std::shared_ptr< type >& t )
+        {
+            return !t || t->is( type::primitive_type::any ) || t->is( type::primitive_type::unknown );
+        }
+
+        bool is_primitive( const std::shared_ptr< type >& t, type::primitive_type primitive )
+        {
+            return is_unknown( t ) || t->is( primitive );
+        }
+
+        /// @brief Checks if a value can be assigned to a slot: its type fits the type of the slot, or it is of type
+        /// any and the slot expects a primitive, which the value is taken out of its box as (the program traps if the
+        /// box holds something else, see code_generation::unbox)
+        bool is_assignable( const std::shared_ptr< type >& slot, const std::shared_ptr< type >& value )
+        {
+            if ( slot->is( value ) )
+                return true;
+
+            return value->is( type::primitive_type::any ) &&
+                   ( slot->is( type::primitive_type::number ) || slot->is( type::primitive_type::string ) ||
+                     slot->is( type::primitive_type::boolean ) );
+        }
+
+        std::string describe( const std::shared_ptr< type >& t )
+        {
+            return t ? t->to_string() : type::to_string( type::primitive_type::unknown );
+        }
+    }  // namespace
+
     bool validator::validate( module* root, compiler::compiler* compiler )
+    {
+        return validate( root, root, compiler );
+    }
+
+    bool validator::validate( statement* node, module* root, compiler::compiler* compiler )
     {
         validator v;
         // Set the compiler instance
@@ -10,7 +48,7 @@ namespace lorraine::ast::type
 
         try
         {
-            root->visit( &v );
+            node->visit( &v );
         }
         catch ( const utils::syntax_error& error )
         {
@@ -60,6 +98,11 @@ namespace lorraine::ast::type
             }
 
             node->type = std::make_shared< type >( table );
+
+            // A constructor of a value of a table type creates a value with the layout of that type
+            if ( last_type && std::holds_alternative< descriptor::table >( last_type->value ) &&
+                 last_type->is( node->type ) )
+                node->type = last_type;
         }
         // Must be an array constructor
         else
@@ -70,7 +113,7 @@ namespace lorraine::ast::type
             {
                 for ( const auto& expr : node->expressions )
                 {
-                    if ( !expr->type->is( array->t ) )
+                    if ( !is_assignable( array->t, expr->type ) )
                     {
                         std::stringstream stream;
 
@@ -141,7 +184,7 @@ namespace lorraine::ast::type
             value->visit( this );
 
             // Now compare the new types. If they are not the same, throw an exception
-            if ( !variable->type->is( value->type ) )
+            if ( !is_assignable( variable->type, value->type ) )
             {
                 std::stringstream stream;
 
@@ -160,4 +203,271 @@ namespace lorraine::ast::type
     {
         return true;
     }
-}  // namespace lorraine::ast::type
\ No newline at end of file
+
+    bool validator::visit( binary_expression* node )
+    {
+        node->left->visit( this );
+        node->right->visit( this );
+
+        const auto& left = node->left->type;
+        const auto& right = node->right->type;
+
+        const auto fail = [ & ]()
+        {
+            std::stringstream stream;
+
+            stream << "cannot apply operator '" << binary_expression::to_string( node->op ) << "' to types '"
+                   << describe( left ) << "' and '" << describe( right ) << "'";
+
+            throw utils::syntax_error( node->location, stream.str() );
+        };
+
+        switch ( node->op )
+        {
+            case binary_operator::add:
+            case binary_operator::subtract:
+            case binary_operator::multiply:
+            case binary_operator::divide:
+            case binary_operator::modulo:
+            case binary_operator::power:
+            {
+                if ( !is_primitive( left, type::primitive_type::number ) ||
+                     !is_primitive( right, type::primitive_type::number ) )
+                    fail();
+
+                node->type = std::make_shared< type >( type::primitive_type::number );
+                break;
+            }
+            case binary_operator::concat:
+            {
+                if ( !is_primitive( left, type::primitive_type::string ) ||
+                     !is_primitive( right, type::primitive_type::string ) )
+                    fail();
+
+                node->type = std::make_shared< type >( type::primitive_type::string );
+                break;
+            }
+            case binary_operator::equal:
+            case binary_operator::not_equal:
+            {
+                node->type = std::make_shared< type >( type::primitive_type::boolean );
+                break;
+            }
+            case binary_operator::less:
+            case binary_operator::less_equal:
+            case binary_operator::greater:
+            case binary_operator::greater_equal:
+            {
+                // Numbers are compared with numbers, strings with strings
+                const bool numbers = is_primitive( left, type::primitive_type::number ) &&
+                                     is_primitive( right, type::primitive_type::number );
+                const bool strings = is_primitive( left, type::primitive_type::string ) &&
+                                     is_primitive( right, type::primitive_type::string );
+
+                if ( !numbers && !strings )
+                    fail();
+
+                node->type = std::make_shared< type >( type::primitive_type::boolean );
+                break;
+            }
+            case binary_operator::logical_and:
+            case binary_operator::logical_or:
+            {
+                // The result is one of the operands, it is of type any if they have different types
+                if ( !is_unknown( left ) && !is_unknown( right ) && left->is( right ) )
+                    node->type = left;
+                else
+                    node->type = std::make_shared< type >( type::primitive_type::any );
+
+                break;
+            }
+        }
+
+        return false;
+    }
+
+    bool validator::visit( unary_expression* node )
+    {
+        node->value->visit( this );
+
+        const auto& value = node->value->type;
+
+        switch ( node->op )
+        {
+            case unary_operator::negate:
+            {
+                if ( is_primitive( value, type::primitive_type::number ) )
+                {
+                    node->type = std::make_shared< type >( type::primitive_type::number );
+                    return false;
+                }
+
+                break;
+            }
+            case unary_operator::logical_not:
+            {
+                node->type = std::make_shared< type >( type::primitive_type::boolean );
+                return false;
+            }
+            case unary_operator::length:
+            {
+                if ( is_primitive( value, type::primitive_type::string ) ||
+                     std::get_if< descriptor::array >( &value->value ) )
+                {
+                    node->type = std::make_shared< type >( type::primitive_type::number );
+                    return false;
+                }
+
+                break;
+            }
+        }
+
+        std::stringstream stream;
+
+        stream << "cannot apply operator '" << unary_expression::to_string( node->op ) << "' to type '"
+               << describe( value ) << "'";
+
+        throw utils::syntax_error( node->location, stream.str() );
+    }
+
+    bool validator::visit( call* node )
+    {
+        node->function->visit( this );
+
+        for ( const auto& argument : node->arguments )
+            argument->visit( this );
+
+        // A call has the type of the value its function returns, if it returns exactly one
+        if ( const auto& function = node->function->type )
+        {
+            if ( const auto descriptor = std::get_if< descriptor::function >( &function->value ) )
+            {
+                if ( descriptor->returns.size() == 1 )
+                    node->type = descriptor->returns.front();
+            }
+        }
+
+        return false;
+    }
+
+    bool validator::visit( name_index* node )
+    {
+        node->variable->visit( this );
+
+        const auto& variable = node->variable->type;
+
+        // Arrays implement the Array interface (see lib/array.lua)
+        if ( variable && std::holds_alternative< descriptor::array >( variable->value ) )
+        {
+            if ( node->name == "length" )
+                node->type = std::make_shared< type >( type::primitive_type::number );
+            else if ( node->name == "toString" )
+            {
+                const auto& element = std::get< descriptor::array >( variable->value ).t;
+
+                // Like in code_generation::create_to_string
+                if ( !element->is( type::primitive_type::number ) && !element->is( type::primitive_type::string ) &&
+                     !element->is( type::primitive_type::boolean ) )
+                    throw utils::syntax_error(
+                        node->location,
+                        "arrays of type '" + element->to_string() + "' cannot be converted to strings yet" );
+
+                node->type = std::make_shared< type >( descriptor::function(
+                    {}, { std::make_shared< type >( type::primitive_type::string ) } ) );
+            }
+            else
+                throw utils::syntax_error(
+                    node->location,
+                    "property '" + node->name + "' does not exist on type '" + variable->to_string() + "'" );
+
+            return false;
+        }
+
+        if ( const auto interface = variable ? std::get_if< descriptor::interface >( &variable->value ) : nullptr )
+        {
+            const auto properties = interface->get_properties( node->name );
+
+            if ( properties.empty() )
+            {
+                throw utils::syntax_error(
+                    node->location,
+                    "property '" + node->name + "' does not exist on type '" + variable->to_string() + "'" );
+                return false;
+            }
+
+            node->type = properties.front().t;
+            return false;
+        }
+
+        // Values of type any are looked up by name at run time, they have no such property if they are not tables
+        if ( is_unknown( variable ) )
+        {
+            node->type = std::make_shared< type >( type::primitive_type::any );
+            return false;
+        }
+
+        const auto table = variable ? std::get_if< descriptor::table >( &variable->value ) : nullptr;
+
+        if ( !table )
+        {
+            throw utils::syntax_error(
+                node->location, "cannot access property '" + node->name + "' of type '" + describe( variable ) + "'" );
+            return false;
+        }
+
+        const auto property = table->get_property( node->name );
+
+        if ( !property )
+        {
+            throw utils::syntax_error(
+                node->location,
+                "property '" + node->name + "' does not exist on type '" + variable->to_string() + "'" );
+            return false;
+        }
+
+        node->type = property->t;
+        return false;
+    }
+
+    bool validator::visit( expression_index* node )
+    {
+        node->variable->visit( this );
+        node->index->visit( this );
+
+        const auto& variable = node->variable->type;
+
+        // Tables in values of type any are indexed by the names of their properties
+        if ( is_unknown( variable ) )
+        {
+            if ( !is_primitive( node->index->type, type::primitive_type::string ) )
+            {
+                throw utils::syntax_error(
+                    node->index->location,
+                    "cannot index a table with a value of type '" + describe( node->index->type ) + "'" );
+                return false;
+            }
+
+            node->type = std::make_shared< type >( type::primitive_type::any );
+            return false;
+        }
+
+        const auto array = std::get_if< descriptor::array >( &variable->value );
+
+        if ( !array )
+        {
+            throw utils::syntax_error( node->location, "cannot index a value of type '" + describe( variable ) + "'" );
+            return false;
+        }
+
+        if ( !is_primitive( node->index->type, type::primitive_type::number ) )
+        {
+            throw utils::syntax_error(
+                node->index->location,
+                "cannot index an array with a value of type '" + describe( node->index->type ) + "'" );
+            return false;
+        }
+
+        node->type = array->t;
+        return false;
+    }
+}  // namespace lorraine::ast::type
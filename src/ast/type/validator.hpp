@@ -14,9 +14,21 @@ namespace lorraine::ast::type
         /// @return True if the AST is valid, false otherwise.
         static bool validate( module *root, compiler::compiler *compiler );
 
+        /// @brief Validates a single top-level statement of a module that is compiled one statement at a time.
+        /// @param node The statement
+        /// @param root The module the statement belongs to
+        /// @param compiler The compiler instance
+        /// @return True if the statement is valid, false otherwise.
+        static bool validate( statement *node, module *root, compiler::compiler *compiler );
+
         bool visit( local_assignment *node ) override;
         bool visit( external_decleration *node ) override;
         bool visit( list_constructor *node ) override;
+        bool visit( binary_expression *node ) override;
+        bool visit( unary_expression *node ) override;
+        bool visit( call *node ) override;
+        bool visit( name_index *node ) override;
+        bool visit( expression_index *node ) override;
 
        private:
         compiler::compiler *compiler;
@@ -38,6 +38,8 @@ namespace lorraine::ast
         visitor_definition( expression, nil_literal );
         visitor_definition( expression, expression_group );
         visitor_definition( expression, list_constructor );
+        visitor_definition( expression, binary_expression );
+        visitor_definition( expression, unary_expression );
 
         // Register visitor patterns for statements
         visitor_definition( statement, block );
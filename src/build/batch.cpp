@@ -0,0 +1,143 @@
+#include "batch.hpp"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/WithColor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "../ast/statement.hpp"
+#include "../utils/utils.hpp"
+#include "build.hpp"
+
+namespace lorraine::build
+{
+    batch::batch(
+        const cli::config& cfg,
+        const std::filesystem::path& output,
+        compiler::compiler_stage stage,
+        unsigned jobs,
+        std::shared_ptr< compiler::session > shared )
+        : cfg( cfg ),
+          output( output ),
+          stage( stage ),
+          jobs( jobs ? jobs : std::max( 1u, std::thread::hardware_concurrency() ) ),
+          shared( shared ? std::move( shared ) : std::make_shared< compiler::session >() )
+    {
+    }
+
+    int batch::compile( const std::vector< std::string >& files )
+    {
+        // Two inputs must never overwrite each other's output
+        if ( stage != compiler::compiler_stage::type )
+        {
+            std::map< std::filesystem::path, std::string > outputs;
+
+            for ( const auto& file : files )
+            {
+                const auto [ it, inserted ] = outputs.emplace( get_output( file ), file );
+
+                if ( !inserted )
+                {
+                    llvm::WithColor::error() << "'" << file << "' and '" << it->second << "' would both be written to '"
+                                             << it->first.string() << "'\n";
+                    return 1;
+                }
+            }
+
+            if ( !output.empty() )
+                std::filesystem::create_directories( output );
+        }
+
+        std::atomic< std::size_t > next = 0, failed = 0;
+
+        const auto work = [ & ]()
+        {
+            compiler::compiler compiler{ cfg, shared };
+
+            for ( std::size_t i = next++; i < files.size(); i = next++ )
+            {
+                if ( !compile( compiler, files[ i ] ) )
+                    ++failed;
+            }
+        };
+
+        const unsigned workers = static_cast< unsigned >( std::min< std::size_t >( jobs, files.size() ) );
+
+        if ( workers <= 1 )
+            work();
+        else
+        {
+            std::vector< std::thread > threads;
+
+            for ( unsigned i = 0; i < workers; ++i )
+                threads.emplace_back( work );
+
+            for ( auto& thread : threads )
+                thread.join();
+        }
+
+        return failed ? 1 : 0;
+    }
+
+    bool batch::compile( compiler::compiler& compiler, const std::string& file ) const
+    {
+        const auto source = utils::io::read_file( file );
+
+        if ( !source )
+        {
+            std::lock_guard< std::mutex > lock( shared->diagnostics );
+            llvm::WithColor::error() << "unable to open file '" << file << "'\n";
+
+            return false;
+        }
+
+        try
+        {
+            const auto main_module = compiler.parse( file, *source );
+
+            if ( !main_module )
+                return false;
+
+            if ( stage == compiler::compiler_stage::type )
+                return compiler.compile( *main_module, stage, llvm::nulls() );
+
+            std::error_code error;
+            llvm::ToolOutputFile out( get_output( file ).string(), error, llvm::sys::fs::OF_None );
+
+            if ( error )
+            {
+                std::lock_guard< std::mutex > lock( shared->diagnostics );
+                llvm::WithColor::error() << "unable to open '" << get_output( file ).string()
+                                         << "': " << error.message() << '\n';
+
+                return false;
+            }
+
+            if ( !compiler.compile( *main_module, stage, out.os() ) )
+                return false;
+
+            out.keep();
+        }
+        catch ( const utils::error& e )
+        {
+            std::lock_guard< std::mutex > lock( shared->diagnostics );
+            llvm::WithColor::error() << file << ": " << e.what() << '\n';
+
+            return false;
+        }
+
+        return true;
+    }
+
+    std::filesystem::path batch::get_output( const std::string& file ) const
+    {
+        std::filesystem::path path{ file };
+        path.replace_extension( get_extension( stage ) );
+
+        return output.empty() ? path : output / path.filename();
+    }
+}  // namespace lorraine::build
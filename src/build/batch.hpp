@@ -0,0 +1,55 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../compiler/compiler.hpp"
+
+namespace lorraine::build
+{
+    /// @brief Compiles many independent files in one process. The files are distributed over a pool of workers, each
+    /// with a compiler (and LLVM context) of its own. The workers share a session, so the target initialization, the
+    /// built-in type definitions and the build cache are only set up once.
+    class batch final
+    {
+       public:
+        /// @brief Creates a new batch compilation
+        /// @param cfg Compiler configuration
+        /// @param output Directory the outputs are written to, or empty to write every output next to its input
+        /// @param stage Stage to compile the files to (type, ir, codegen or object)
+        /// @param jobs Number of worker threads, 0 uses one worker per hardware thread
+        /// @param shared Session shared by the workers, a new session is created if none is given
+        explicit batch(
+            const cli::config& cfg,
+            const std::filesystem::path& output,
+            compiler::compiler_stage stage,
+            unsigned jobs,
+            std::shared_ptr< compiler::session > shared = nullptr );
+
+        /// @brief Compiles all files
+        /// @param files Paths of the files
+        /// @return Process exit code (non-zero if a file failed to compile)
+        int compile( const std::vector< std::string >& files );
+
+       private:
+        cli::config cfg;
+        std::filesystem::path output;
+        compiler::compiler_stage stage;
+        unsigned jobs;
+
+        std::shared_ptr< compiler::session > shared;
+
+        /// @brief Gets the file the output of an input file is written to
+        /// @param file Path of the input file
+        /// @return Path of the output file
+        std::filesystem::path get_output( const std::string& file ) const;
+
+        /// @brief Compiles a single file
+        /// @param compiler Compiler of the worker
+        /// @param file Path of the file
+        /// @return False if an error was reported
+        bool compile( compiler::compiler& compiler, const std::string& file ) const;
+    };
+}  // namespace lorraine::build
@@ -0,0 +1,525 @@
+#include "build.hpp"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/WithColor.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <unordered_set>
+
+#include "../cache/hash.hpp"
+#include "../cache/interface.hpp"
+#include "../lexer/lexer.hpp"
+#include "../utils/utils.hpp"
+
+namespace lorraine::build
+{
+    namespace
+    {
+        /// @brief Name of the file that keeps the state of the last build (inside the output directory)
+        constexpr const char* state_file = ".lorraine-build";
+
+        /// @brief Version of the state file format, older states are ignored
+        constexpr const char* state_version = "lorraine-build 1";
+
+        std::string hash_content( std::string_view content )
+        {
+            cache::hasher hash;
+            hash.update( content );
+
+            return hash.digest();
+        }
+
+        /// @brief Hashes a file that is not part of the project (e.g. a library module)
+        std::string hash_file( const std::string& path )
+        {
+            const auto content = utils::io::read_file( path );
+
+            return content ? hash_content( *content ) : std::string{};
+        }
+
+        /// @brief Finds the names of all modules a source imports ('import { ... } from "name"') without parsing it
+        std::vector< std::string > scan_imports( const std::string_view& source, compiler::compiler* compiler )
+        {
+            std::vector< std::string > imports;
+
+            try
+            {
+                lexer::lexer lexer( source, compiler );
+                bool in_import = false;
+
+                for ( ; lexer.current().type != lexer::token_type::eof; lexer.next() )
+                {
+                    const auto& token = lexer.current();
+
+                    if ( token.type == lexer::token_type::kw_import )
+                        in_import = true;
+                    else if ( in_import && token.type == lexer::token_type::kw_from )
+                    {
+                        if ( lexer.peek().type == lexer::token_type::string )
+                        {
+                            lexer.next();
+                            imports.emplace_back( lexer.current().value );
+                        }
+
+                        in_import = false;
+                    }
+                }
+            }
+            catch ( const utils::syntax_error& )
+            {
+                // The error is reported when the module gets compiled
+            }
+
+            return imports;
+        }
+    }  // namespace
+
+    std::string get_extension( compiler::compiler_stage stage )
+    {
+        switch ( stage )
+        {
+            case compiler::compiler_stage::ir: return ".ll";
+            case compiler::compiler_stage::object: return ".o";
+            default: return ".bc";
+        }
+    }
+
+    project::project(
+        compiler::compiler& compiler,
+        const std::filesystem::path& root,
+        const std::filesystem::path& output,
+        compiler::compiler_stage stage )
+        : compiler( compiler ),
+          root( std::filesystem::absolute( root ).lexically_normal() ),
+          output( std::filesystem::absolute( output ).lexically_normal() ),
+          stage( stage )
+    {
+        // Directories are compared by path, so they must not end with a separator ('project/')
+        if ( !this->root.has_filename() )
+            this->root = this->root.parent_path();
+
+        if ( !this->output.has_filename() )
+            this->output = this->output.parent_path();
+    }
+
+    int project::build()
+    {
+        if ( !scan() )
+            return 1;
+
+        return compile();
+    }
+
+    int project::update( const std::vector< std::filesystem::path >& changed )
+    {
+        std::vector< std::filesystem::path > modules;
+
+        for ( const auto& file : changed )
+        {
+            const auto path = std::filesystem::absolute( file ).lexically_normal();
+
+            if ( path.extension() == ".lua" )
+            {
+                modules.push_back( path );
+                continue;
+            }
+
+            // A directory that was created, moved or deleted: all modules inside it changed
+            for ( const auto& [ module, _ ] : units )
+            {
+                const auto relative = std::filesystem::path{ module }.lexically_relative( path );
+
+                if ( !relative.empty() && *relative.begin() != ".." )
+                    modules.emplace_back( module );
+            }
+
+            std::error_code error;
+            std::filesystem::recursive_directory_iterator it( path, error ), end;
+
+            for ( ; it != end; it.increment( error ) )
+                modules.push_back( it->path() );
+        }
+
+        for ( const auto& path : modules )
+        {
+            if ( !is_module( path ) )
+                continue;
+
+            const auto it = units.find( path.string() );
+
+            if ( auto module = read( path ) )
+                units.insert_or_assign( path.string(), std::move( *module ) );
+            else if ( it != units.end() )
+            {
+                // The module was deleted, so is its output
+                std::error_code error;
+                std::filesystem::remove( get_output( it->second ), error );
+
+                units.erase( it );
+            }
+        }
+
+        return compile();
+    }
+
+    bool project::is_module( const std::filesystem::path& path ) const
+    {
+        if ( path.extension() != ".lua" )
+            return false;
+
+        const auto is_inside = []( const std::filesystem::path& file, const std::filesystem::path& directory )
+        {
+            const auto relative = file.lexically_relative( directory );
+            return !relative.empty() && *relative.begin() != "..";
+        };
+
+        if ( !is_inside( path, root ) || is_inside( path, output ) )
+            return false;
+
+        // Hidden directories (e.g. '.git') are not part of the project
+        const auto directory = path.parent_path().lexically_relative( root );
+
+        for ( const auto& component : directory )
+        {
+            if ( component != "." && component.string().front() == '.' )
+                return false;
+        }
+
+        return true;
+    }
+
+    int project::compile()
+    {
+        const auto order = sort();
+
+        if ( order.empty() && !units.empty() )
+            return 1;
+
+        // The state of the last build is only read once, afterwards it is kept in memory
+        const std::string settings = get_settings_hash();
+
+        if ( settings != state_settings )
+        {
+            state = load( settings );
+            state_settings = settings;
+        }
+
+        const auto& previous = state;
+
+        std::unordered_map< std::string, record > records;
+        std::unordered_set< std::string > failed;
+        std::size_t compiled = 0, skipped = 0, index = 0;
+
+        for ( const auto& path : order )
+        {
+            const unit& module = units.at( path );
+            ++index;
+
+            // Fingerprint the imports as they are now. Modules of the project were handled before this one, so their
+            // records are already up to date.
+            record current{ module.source_hash, "", {} };
+            bool blocked = false;
+
+            for ( const auto& import : module.imports )
+            {
+                const auto it = units.find( import );
+
+                if ( it == units.end() )
+                    current.dependencies[ import ] = hash_file( import );
+                else if ( failed.count( import ) )
+                    blocked = true;
+                else
+                    current.dependencies[ import ] = records.at( import ).interface_hash;
+            }
+
+            if ( blocked )
+            {
+                llvm::WithColor::warning() << "skipping '" << module.name
+                                           << "', an imported module failed to compile\n";
+
+                failed.insert( path );
+                continue;
+            }
+
+            const auto last = previous.find( module.name );
+            const bool has_output =
+                stage == compiler::compiler_stage::type || std::filesystem::exists( get_output( module ) );
+
+            if ( last != previous.end() && has_output && last->second.source_hash == current.source_hash &&
+                 last->second.dependencies == current.dependencies )
+            {
+                records[ path ] = last->second;
+                ++skipped;
+                continue;
+            }
+
+            std::cout << '[' << index << '/' << order.size() << "] compiling " << module.name << std::endl;
+
+            const auto main_module = compiler.parse( get_module_name( module ), module.source );
+
+            if ( !main_module || !compile( *main_module, module ) )
+            {
+                failed.insert( path );
+                continue;
+            }
+
+            current.interface_hash = cache::get_interface_hash( *main_module );
+            records[ path ] = std::move( current );
+            ++compiled;
+        }
+
+        // Only successfully built modules are remembered, failed ones are compiled again next time
+        std::unordered_map< std::string, record > current_state;
+
+        for ( auto& [ path, module_record ] : records )
+            current_state[ units.at( path ).name ] = std::move( module_record );
+
+        state = std::move( current_state );
+        save( settings, state );
+
+        std::cout << compiled << " compiled, " << skipped << " up to date, " << failed.size() << " failed\n";
+
+        return failed.empty() ? 0 : 1;
+    }
+
+    bool project::scan()
+    {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it( root, error ), end;
+
+        if ( error )
+        {
+            llvm::WithColor::error() << "unable to open project directory '" << root.string() << "'\n";
+            return false;
+        }
+
+        for ( ; it != end; it.increment( error ) )
+        {
+            const auto& path = it->path();
+
+            // Skip outputs and hidden directories (e.g. '.git'). Dangling symlinks are neither directories nor
+            // modules.
+            if ( it->is_directory( error ) )
+            {
+                if ( path == output || path.filename().string().front() == '.' )
+                    it.disable_recursion_pending();
+
+                continue;
+            }
+
+            if ( path.extension() != ".lua" )
+                continue;
+
+            if ( auto module = read( path ) )
+                units.emplace( path.string(), std::move( *module ) );
+        }
+
+        return true;
+    }
+
+    std::optional< project::unit > project::read( const std::filesystem::path& path )
+    {
+        const auto source = utils::io::read_file( path.string() );
+
+        if ( !source )
+            return std::nullopt;
+
+        unit module;
+        module.path = path;
+        module.name = path.lexically_relative( root ).string();
+        module.source = *source;
+        module.source_hash = hash_content( module.source );
+
+        // Resolve imports exactly like the parser does
+        const auto info = ast::module::information::get( get_module_name( module ), module.source );
+
+        for ( const auto& name : scan_imports( module.source, &compiler ) )
+        {
+            if ( const auto import = ast::module::get_information( info, name ) )
+                module.imports.push_back( import->absolute() );
+        }
+
+        return module;
+    }
+
+    std::vector< std::string > project::sort()
+    {
+        enum class mark
+        {
+            visiting,
+            done
+        };
+
+        std::vector< std::string > order, stack;
+        std::unordered_map< std::string, mark > marks;
+
+        // Sort the roots so the build order does not depend on the order of the directory listing
+        std::vector< std::string > paths;
+
+        for ( const auto& [ path, _ ] : units )
+            paths.push_back( path );
+
+        std::sort( paths.begin(), paths.end() );
+
+        std::function< bool( const std::string& ) > visit = [ & ]( const std::string& path ) -> bool
+        {
+            const auto it = marks.find( path );
+
+            if ( it != marks.end() )
+            {
+                if ( it->second == mark::done )
+                    return true;
+
+                // Report the cycle starting at the module that closes it
+                std::string cycle;
+
+                for ( auto entry = std::find( stack.begin(), stack.end(), path ); entry != stack.end(); ++entry )
+                    cycle += units.at( *entry ).name + " -> ";
+
+                llvm::WithColor::error() << "import cycle: " << cycle << units.at( path ).name << '\n';
+                return false;
+            }
+
+            marks[ path ] = mark::visiting;
+            stack.push_back( path );
+
+            for ( const auto& import : units.at( path ).imports )
+            {
+                if ( units.count( import ) && !visit( import ) )
+                    return false;
+            }
+
+            stack.pop_back();
+            marks[ path ] = mark::done;
+            order.push_back( path );
+
+            return true;
+        };
+
+        for ( const auto& path : paths )
+        {
+            if ( !visit( path ) )
+                return {};
+        }
+
+        return order;
+    }
+
+    bool project::compile( ast::module& main_module, const unit& module )
+    {
+        if ( stage == compiler::compiler_stage::type )
+            return compiler.compile( main_module, stage, llvm::nulls() );
+
+        const auto file = get_output( module );
+
+        std::filesystem::create_directories( file.parent_path() );
+
+        std::error_code error;
+        llvm::ToolOutputFile out( file.string(), error, llvm::sys::fs::OF_None );
+
+        if ( error )
+        {
+            llvm::WithColor::error() << "unable to open '" << file.string() << "': " << error.message() << '\n';
+            return false;
+        }
+
+        if ( !compiler.compile( main_module, stage, out.os() ) )
+            return false;
+
+        out.keep();
+
+        return true;
+    }
+
+    std::filesystem::path project::get_output( const unit& module ) const
+    {
+        auto path = output / module.name;
+
+        return path.replace_extension( get_extension( stage ) );
+    }
+
+    std::string project::get_module_name( const unit& module )
+    {
+        return module.path.lexically_relative( utils::system::get_working_dir() ).string();
+    }
+
+    std::string project::get_settings_hash()
+    {
+        cache::hasher hash;
+        hash.update( compiler.get_settings_hash( stage ) );
+
+        // Every module implicitly imports the array type definitions
+        const auto array = ast::module::get_information(
+            nullptr, compiler.cfg.get< std::string >( "pathToTypeDefinitions" ) + "/array" );
+
+        if ( array )
+            hash.update( hash_file( array->absolute() ) );
+
+        return hash.digest();
+    }
+
+    std::unordered_map< std::string, record > project::load( const std::string& settings ) const
+    {
+        std::unordered_map< std::string, record > records;
+        std::ifstream in( output / state_file );
+
+        std::string line;
+
+        if ( !std::getline( in, line ) || line != state_version )
+            return records;
+
+        if ( !std::getline( in, line ) || line != "settings\t" + settings )
+            return records;
+
+        // Every module is followed by the dependencies it was compiled against:
+        //   module <tab> name <tab> source hash <tab> interface hash
+        //   import <tab> path <tab> fingerprint
+        record* current = nullptr;
+
+        while ( std::getline( in, line ) )
+        {
+            std::vector< std::string > fields;
+            std::stringstream stream( line );
+
+            for ( std::string field; std::getline( stream, field, '\t' ); )
+                fields.push_back( field );
+
+            // The last field may be empty (e.g. the fingerprint of a file that could not be read)
+            if ( ( fields.size() == 3 || fields.size() == 4 ) && fields[ 0 ] == "module" )
+            {
+                fields.resize( 4 );
+                current = &( records[ fields[ 1 ] ] = record{ fields[ 2 ], fields[ 3 ], {} } );
+            }
+            else if ( ( fields.size() == 2 || fields.size() == 3 ) && fields[ 0 ] == "import" && current )
+            {
+                fields.resize( 3 );
+                current->dependencies[ fields[ 1 ] ] = fields[ 2 ];
+            }
+            else
+                return {};
+        }
+
+        return records;
+    }
+
+    void project::save( const std::string& settings, const std::unordered_map< std::string, record >& records ) const
+    {
+        std::filesystem::create_directories( output );
+
+        std::ofstream out( output / state_file );
+
+        out << state_version << '\n';
+        out << "settings\t" << settings << '\n';
+
+        for ( const auto& [ name, module ] : records )
+        {
+            out << "module\t" << name << '\t' << module.source_hash << '\t' << module.interface_hash << '\n';
+
+            for ( const auto& [ path, fingerprint ] : module.dependencies )
+                out << "import\t" << path << '\t' << fingerprint << '\n';
+        }
+    }
+}  // namespace lorraine::build
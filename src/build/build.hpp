@@ -0,0 +1,144 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../compiler/compiler.hpp"
+
+namespace lorraine::build
+{
+    /// @brief Gets the file extension of the output of a stage
+    /// @param stage The stage (ir, codegen or object)
+    /// @return Extension including the dot
+    std::string get_extension( compiler::compiler_stage stage );
+
+    /// @brief What the last build knew about a module
+    struct record
+    {
+        std::string source_hash, interface_hash;
+
+        /// @brief Fingerprint of every module this one imported when it was compiled. Modules of the project are
+        /// fingerprinted by their interface hash, everything else by its content.
+        std::map< std::string, std::string > dependencies;
+    };
+
+    /// @brief Incrementally builds every module of a project directory. Modules are compiled in import order and
+    /// only if their source, the interface of a module they import or the compiler settings changed since the last
+    /// build. A module whose interface stays the same does not cause the modules importing it to be rebuilt.
+    class project final
+    {
+       public:
+        /// @brief Creates a new project
+        /// @param compiler Compiler used for every module
+        /// @param root Directory containing the modules (*.lua)
+        /// @param output Directory the outputs and the build state are written to
+        /// @param stage Stage to compile modules to (type, ir, codegen or object)
+        explicit project(
+            compiler::compiler& compiler,
+            const std::filesystem::path& root,
+            const std::filesystem::path& output,
+            compiler::compiler_stage stage );
+
+        /// @brief Finds all modules of the project and builds the out-of-date ones
+        /// @return Process exit code (non-zero if a module failed to compile)
+        int build();
+
+        /// @brief Re-reads modules that were changed, created or deleted since the last build and builds the
+        /// out-of-date ones. All other modules are not read again. Requires a previous call to `build`.
+        /// @param changed Paths of the changed files and directories, files that are not modules of the project are
+        /// ignored
+        /// @return Process exit code (non-zero if a module failed to compile)
+        int update( const std::vector< std::filesystem::path >& changed );
+
+        /// @brief Checks if a file is (or would be) a module of the project
+        /// @param path Absolute path of the file
+        /// @return True if the file is a module of the project
+        bool is_module( const std::filesystem::path& path ) const;
+
+        const std::filesystem::path& get_root() const
+        {
+            return root;
+        }
+
+        const std::filesystem::path& get_output_directory() const
+        {
+            return output;
+        }
+
+       private:
+        struct unit
+        {
+            std::filesystem::path path;
+
+            /// @brief Path relative to the project root, used for outputs and the build state
+            std::string name;
+
+            std::string source, source_hash;
+
+            /// @brief Absolute paths of all imported modules
+            std::vector< std::string > imports;
+        };
+
+        compiler::compiler& compiler;
+        std::filesystem::path root, output;
+        compiler::compiler_stage stage;
+
+        /// @brief Modules of the project by absolute path
+        std::unordered_map< std::string, unit > units;
+
+        /// @brief Records of the last build by module name and the settings they were built with
+        std::unordered_map< std::string, record > state;
+        std::string state_settings;
+
+        /// @brief Finds all modules below the project root and the modules they import
+        /// @return False if the project directory could not be opened
+        bool scan();
+
+        /// @brief Reads a module and finds the modules it imports
+        /// @param path Absolute path of the module
+        /// @return The module or std::nullopt if it could not be read
+        std::optional< unit > read( const std::filesystem::path& path );
+
+        /// @brief Compiles every module that changed since the last build, in import order
+        /// @return Process exit code (non-zero if a module failed to compile)
+        int compile();
+
+        /// @brief Compiles a parsed module and writes it to its output file
+        /// @param main_module The parsed module
+        /// @param module The module
+        /// @return False if the module failed to compile, its output file is removed in that case
+        bool compile( ast::module& main_module, const unit& module );
+
+        /// @brief Orders the modules so that every module comes after the modules it imports
+        /// @return Absolute paths in build order or an empty list if the imports form a cycle
+        std::vector< std::string > sort();
+
+        /// @brief Gets the file a module is compiled to
+        /// @param module The module
+        /// @return Path of the output file
+        std::filesystem::path get_output( const unit& module ) const;
+
+        /// @brief Gets the path a module name is passed to the compiler with
+        /// @param module The module
+        /// @return Path relative to the working directory
+        static std::string get_module_name( const unit& module );
+
+        /// @brief Hashes the compiler settings and the built-in type definitions every module depends on
+        /// @return Hexadecimal hash
+        std::string get_settings_hash();
+
+        /// @brief Loads the state of the last build
+        /// @param settings Current settings hash, the state is discarded if it was built with different settings
+        /// @return Records by module name
+        std::unordered_map< std::string, record > load( const std::string& settings ) const;
+
+        /// @brief Saves the state of this build
+        /// @param settings Current settings hash
+        /// @param records Records by module name
+        void save( const std::string& settings, const std::unordered_map< std::string, record >& records ) const;
+    };
+}  // namespace lorraine::build
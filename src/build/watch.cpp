@@ -0,0 +1,168 @@
+#include "watch.hpp"
+
+#include <llvm/Support/WithColor.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "../utils/timer.hpp"
+
+namespace lorraine::build
+{
+    namespace
+    {
+        /// @brief Events that can change a module or add and remove modules
+        constexpr std::uint32_t watched_events =
+            IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+
+        /// @brief Time without further changes after which a rebuild starts
+        constexpr int quiet_period = 20;
+    }  // namespace
+
+    watcher::watcher( project& target ) : target( target )
+    {
+    }
+
+    watcher::~watcher()
+    {
+        if ( notify >= 0 )
+            ::close( notify );
+    }
+
+    int watcher::run()
+    {
+        notify = ::inotify_init1( IN_CLOEXEC );
+
+        if ( notify < 0 )
+        {
+            llvm::WithColor::error() << "unable to watch for changes: " << std::strerror( errno ) << '\n';
+            return 1;
+        }
+
+        // Watch before building, so that changes made during the first build are not missed
+        watch( target.get_root() );
+
+        target.build();
+
+        std::cout << "watching " << target.get_root().string() << " for changes" << std::endl;
+
+        while ( true )
+        {
+            const auto changed = wait();
+
+            if ( changed.empty() )
+                continue;
+
+            utils::timer timer;
+            timer.start();
+
+            target.update( changed );
+
+            std::cout << "updated in " << timer.elapsed< std::chrono::milliseconds >() << "ms" << std::endl;
+        }
+    }
+
+    void watcher::watch( const std::filesystem::path& directory )
+    {
+        const int descriptor = ::inotify_add_watch( notify, directory.c_str(), watched_events );
+
+        if ( descriptor < 0 )
+        {
+            llvm::WithColor::warning() << "unable to watch '" << directory.string() << "': " << std::strerror( errno )
+                                       << '\n';
+            return;
+        }
+
+        directories[ descriptor ] = directory;
+
+        std::error_code error;
+
+        for ( const auto& entry : std::filesystem::directory_iterator( directory, error ) )
+        {
+            const auto& path = entry.path();
+
+            // Outputs and hidden directories never contain modules
+            if ( entry.is_directory( error ) && path != target.get_output_directory() &&
+                 path.filename().string().front() != '.' )
+                watch( path );
+        }
+    }
+
+    std::vector< std::filesystem::path > watcher::wait()
+    {
+        std::vector< std::filesystem::path > changed;
+
+        alignas( inotify_event ) char buffer[ 4096 ];
+
+        // Block until the first change, then keep collecting until it is quiet again
+        int timeout = -1;
+
+        while ( true )
+        {
+            pollfd descriptor{ notify, POLLIN, 0 };
+            const int ready = ::poll( &descriptor, 1, timeout );
+
+            if ( ready < 0 && errno == EINTR )
+                continue;
+
+            if ( ready <= 0 )
+                break;
+
+            const ssize_t length = ::read( notify, buffer, sizeof( buffer ) );
+
+            if ( length <= 0 )
+                break;
+
+            for ( char* position = buffer; position < buffer + length; )
+            {
+                const auto* event = reinterpret_cast< const inotify_event* >( position );
+                position += sizeof( inotify_event ) + event->len;
+
+                const auto it = directories.find( event->wd );
+
+                if ( it == directories.end() )
+                    continue;
+
+                // The watch was removed because its directory is gone
+                if ( event->mask & IN_IGNORED )
+                {
+                    directories.erase( it );
+                    continue;
+                }
+
+                if ( event->len == 0 )
+                    continue;
+
+                const auto path = it->second / event->name;
+
+                if ( event->mask & IN_ISDIR )
+                {
+                    // Outputs and hidden directories never contain modules
+                    if ( path == target.get_output_directory() || path.filename().string().front() == '.' )
+                        continue;
+
+                    if ( event->mask & ( IN_CREATE | IN_MOVED_TO ) )
+                        watch( path );
+                }
+                // Files that are only created are reported again once they are written
+                else if ( !target.is_module( path ) || event->mask == IN_CREATE )
+                    continue;
+
+                changed.push_back( path );
+            }
+
+            timeout = quiet_period;
+        }
+
+        std::sort( changed.begin(), changed.end() );
+        changed.erase( std::unique( changed.begin(), changed.end() ), changed.end() );
+
+        return changed;
+    }
+}  // namespace lorraine::build
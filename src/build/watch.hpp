@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "build.hpp"
+
+namespace lorraine::build
+{
+    /// @brief Keeps a project up to date. The project is built once, after that the project directory is watched
+    /// with inotify and every change triggers an update of the project: only the changed modules are read again, and
+    /// only those and the modules whose imports changed their interface are compiled again.
+    class watcher final
+    {
+       public:
+        /// @brief Creates a new watcher
+        /// @param target The project to keep up to date
+        explicit watcher( project& target );
+
+        ~watcher();
+
+        /// @brief Builds the project and rebuilds it on every change until the process is terminated
+        /// @return Process exit code (non-zero if the project directory could not be watched)
+        int run();
+
+       private:
+        project& target;
+
+        int notify = -1;
+
+        /// @brief Watched directories by watch descriptor
+        std::unordered_map< int, std::filesystem::path > directories;
+
+        /// @brief Watches a directory and all of its subdirectories that can contain modules
+        /// @param directory The directory
+        void watch( const std::filesystem::path& directory );
+
+        /// @brief Waits for changes and collects them until no more changes arrive for a short time, so that a
+        /// save that touches several files (or writes a file in several steps) results in a single rebuild
+        /// @return Paths of the changed files
+        std::vector< std::filesystem::path > wait();
+    };
+}  // namespace lorraine::build
@@ -0,0 +1,20 @@
+#include "hash.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+
+namespace lorraine::cache
+{
+    void hasher::update( std::string_view value )
+    {
+        const std::uint64_t size = value.size();
+
+        sha.update(
+            llvm::ArrayRef< std::uint8_t >( reinterpret_cast< const std::uint8_t* >( &size ), sizeof( size ) ) );
+        sha.update( llvm::StringRef( value.data(), value.size() ) );
+    }
+
+    std::string hasher::digest()
+    {
+        return llvm::toHex( sha.final(), true );
+    }
+}  // namespace lorraine::cache
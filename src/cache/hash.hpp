@@ -0,0 +1,35 @@
+#pragma once
+
+#include <llvm/Support/SHA1.h>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace lorraine::cache
+{
+    /// @brief Incrementally builds a content hash that is used as a cache key. Every value is prefixed with its size so
+    /// that two different sequences of values can never produce the same byte stream.
+    class hasher final
+    {
+       public:
+        /// @brief Adds a string to the hash
+        /// @param value The string
+        void update( std::string_view value );
+
+        /// @brief Adds a number (or boolean) to the hash
+        /// @param value The number
+        template< typename T >
+        std::enable_if_t< std::is_arithmetic_v< T > > update( T value )
+        {
+            update( std::string_view{ std::to_string( value ) } );
+        }
+
+        /// @brief Finalizes the hash. No values may be added afterwards.
+        /// @return Lower case hexadecimal digest
+        std::string digest();
+
+       private:
+        llvm::SHA1 sha;
+    };
+}  // namespace lorraine::cache
@@ -0,0 +1,157 @@
+#include "interface.hpp"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "hash.hpp"
+
+namespace lorraine::cache
+{
+    namespace
+    {
+        // Types are shared pointers and can, in theory, refer back to themselves through interface members. Nothing
+        // meaningful is nested this deep, so the description is simply cut off.
+        constexpr int max_depth = 32;
+
+        void describe( const ast::type::type& type, std::stringstream& out, int depth );
+
+        void describe( const ast::type::type_list& types, std::stringstream& out, int depth )
+        {
+            for ( const auto& type : types )
+            {
+                describe( *type, out, depth );
+                out << ',';
+            }
+        }
+
+        void describe( const ast::type::type& type, std::stringstream& out, int depth )
+        {
+            if ( depth > max_depth )
+            {
+                out << "...";
+                return;
+            }
+
+            if ( const auto table = std::get_if< ast::type::descriptor::table >( &type.value ) )
+            {
+                out << '{';
+
+                for ( const auto& property : table->properties )
+                {
+                    out << property.name << ( property.is_optional ? "?:" : ":" );
+                    describe( *property.t, out, depth + 1 );
+                    out << ',';
+                }
+
+                out << '}';
+            }
+            else if ( const auto function = std::get_if< ast::type::descriptor::function >( &type.value ) )
+            {
+                out << '(';
+                describe( function->arguments, out, depth + 1 );
+                out << ")=>(";
+                describe( function->returns, out, depth + 1 );
+                out << ')';
+            }
+            else if ( const auto vararg = std::get_if< ast::type::descriptor::vararg >( &type.value ) )
+            {
+                out << "...";
+                describe( *vararg->t, out, depth + 1 );
+            }
+            else if ( const auto array = std::get_if< ast::type::descriptor::array >( &type.value ) )
+            {
+                describe( *array->t, out, depth + 1 );
+                out << "[]";
+            }
+            else if ( const auto interface = std::get_if< ast::type::descriptor::interface >( &type.value ) )
+            {
+                out << "interface " << interface->name << '<';
+
+                for ( const auto& generic : interface->generics )
+                    out << generic.to_string() << ',';
+
+                out << ">{";
+
+                for ( const auto& property : interface->properties )
+                {
+                    out << property.name << ( property.is_optional ? "?:" : ":" );
+                    describe( *property.t, out, depth + 1 );
+                    out << ',';
+                }
+
+                out << '}';
+            }
+            else
+                out << type.to_string();
+        }
+
+        void hash_interface( const ast::module& module, hasher& hash )
+        {
+            // The export maps are unordered, sort them so the hash doesn't depend on insertion order
+            std::map< std::string, std::string > types, variables;
+
+            for ( const auto& [ name, type ] : module.body->export_types )
+                types.emplace( name, cache::describe( *type ) );
+
+            for ( const auto& [ name, type ] : module.body->export_variables )
+                variables.emplace( name, cache::describe( *type ) );
+
+            hash.update( std::string_view{ "types" } );
+
+            for ( const auto& [ name, description ] : types )
+            {
+                hash.update( name );
+                hash.update( description );
+            }
+
+            hash.update( std::string_view{ "variables" } );
+
+            for ( const auto& [ name, description ] : variables )
+            {
+                hash.update( name );
+                hash.update( description );
+            }
+        }
+
+        void hash_imports( const ast::module& module, hasher& hash, int depth )
+        {
+            if ( depth > max_depth )
+                return;
+
+            for ( const auto& statement : module.body->body )
+            {
+                if ( const auto import = dynamic_cast< ast::import* >( statement.get() ) )
+                {
+                    hash.update( import->module->info->absolute() );
+                    hash_interface( *import->module, hash );
+                    hash_imports( *import->module, hash, depth + 1 );
+                }
+            }
+        }
+    }  // namespace
+
+    std::string describe( const ast::type::type& type )
+    {
+        std::stringstream out;
+        describe( type, out, 0 );
+
+        return out.str();
+    }
+
+    std::string get_interface_hash( const ast::module& module )
+    {
+        hasher hash;
+        hash_interface( module, hash );
+
+        return hash.digest();
+    }
+
+    std::string get_imports_hash( const ast::module& module )
+    {
+        hasher hash;
+        hash_imports( module, hash, 0 );
+
+        return hash.digest();
+    }
+}  // namespace lorraine::cache
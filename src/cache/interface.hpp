@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include "../ast/statement.hpp"
+
+namespace lorraine::cache
+{
+    /// @brief Describes a type including everything that makes it distinct from other types. Unlike
+    /// `type::to_string` this also lists the members of interfaces.
+    /// @param type The type
+    /// @return Description of the type
+    std::string describe( const ast::type::type& type );
+
+    /// @brief Hashes the exported types and variables of a module. Two modules with the same interface hash can be
+    /// used interchangeably by modules that import them.
+    /// @param module The module
+    /// @return Hexadecimal hash
+    std::string get_interface_hash( const ast::module& module );
+
+    /// @brief Hashes the interfaces of everything a module imports, including the imports of imported modules
+    /// @param module The module
+    /// @return Hexadecimal hash
+    std::string get_imports_hash( const ast::module& module );
+}  // namespace lorraine::cache
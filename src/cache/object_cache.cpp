@@ -0,0 +1,64 @@
+#include "object_cache.hpp"
+
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "hash.hpp"
+
+namespace lorraine::cache
+{
+    void object_cache::notifyObjectCompiled( const llvm::Module* module, llvm::MemoryBufferRef object )
+    {
+        std::string key;
+
+        {
+            std::lock_guard< std::mutex > lock( pending_mutex );
+
+            const auto it = pending.find( module );
+
+            if ( it == pending.end() )
+                return;
+
+            key = std::move( it->second );
+            pending.erase( it );
+        }
+
+        objects.save( "objects/" + key + ".o", object.getBuffer() );
+    }
+
+    std::unique_ptr< llvm::MemoryBuffer > object_cache::getObject( const llvm::Module* module )
+    {
+        std::string key = get_key( *module );
+
+        if ( auto object = objects.load( "objects/" + key + ".o" ) )
+            return object;
+
+        std::lock_guard< std::mutex > lock( pending_mutex );
+        pending[ module ] = std::move( key );
+
+        return nullptr;
+    }
+
+    std::string object_cache::get_target_key(
+        const std::string& triple,
+        const std::string& cpu,
+        const std::string& features,
+        int optimization_level )
+    {
+        return triple + ';' + cpu + ';' + features + ";O" + std::to_string( optimization_level );
+    }
+
+    std::string object_cache::get_key( const llvm::Module& module ) const
+    {
+        // Bitcode is a deterministic serialization of the module and cheaper to produce than textual IR
+        llvm::SmallVector< char, 0 > bitcode;
+        llvm::raw_svector_ostream stream( bitcode );
+        llvm::WriteBitcodeToFile( module, stream );
+
+        hasher hash;
+        hash.update( target );
+        hash.update( std::string_view{ bitcode.data(), bitcode.size() } );
+
+        return hash.digest();
+    }
+}  // namespace lorraine::cache
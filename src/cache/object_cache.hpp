@@ -0,0 +1,52 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "store.hpp"
+
+namespace lorraine::cache
+{
+    /// @brief Caches compiled object files on disk. An object is keyed on the IR of the module it was compiled from
+    /// and on everything that affects code generation (target triple, CPU, features and optimization level), so a
+    /// module that did not change is never compiled twice.
+    class object_cache final : public llvm::ObjectCache
+    {
+       public:
+        /// @brief Creates a new object cache
+        /// @param objects The store that holds the objects
+        /// @param target A description of the code generation settings, see `get_target_key`
+        explicit object_cache( store& objects, const std::string& target ) : objects( objects ), target( target )
+        {
+        }
+
+        /// @brief Called by the compiler after it generated an object for a module that missed the cache
+        void notifyObjectCompiled( const llvm::Module* module, llvm::MemoryBufferRef object ) override;
+
+        /// @brief Called by the compiler before it generates an object for a module
+        /// @return The cached object or nullptr
+        std::unique_ptr< llvm::MemoryBuffer > getObject( const llvm::Module* module ) override;
+
+        /// @brief Builds the part of the cache key that describes the code generation settings
+        static std::string get_target_key(
+            const std::string& triple,
+            const std::string& cpu,
+            const std::string& features,
+            int optimization_level );
+
+       private:
+        store& objects;
+        std::string target;
+
+        /// @brief Code generation runs passes over the module before `notifyObjectCompiled` is called, which changes
+        /// its IR. The key is therefore computed once in `getObject` and remembered until the object is stored.
+        std::unordered_map< const llvm::Module*, std::string > pending;
+        std::mutex pending_mutex;
+
+        std::string get_key( const llvm::Module& module ) const;
+    };
+}  // namespace lorraine::cache
@@ -0,0 +1,155 @@
+#include "store.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+#include <unistd.h>
+
+namespace lorraine::cache
+{
+    store::store( const std::filesystem::path& root, std::uintmax_t max_size ) : root( root ), max_size( max_size )
+    {
+        std::error_code error;
+        std::filesystem::create_directories( root, error );
+    }
+
+    std::unique_ptr< llvm::MemoryBuffer > store::load( const std::string& name )
+    {
+        const auto path = root / name;
+
+        auto buffer = llvm::MemoryBuffer::getFile( path.string(), false, false );
+
+        if ( !buffer )
+            return nullptr;
+
+        // Refresh the entry so it is evicted last
+        std::error_code error;
+        std::filesystem::last_write_time( path, std::filesystem::file_time_type::clock::now(), error );
+
+        return std::move( *buffer );
+    }
+
+    void store::save( const std::string& name, llvm::StringRef data )
+    {
+        static std::atomic< unsigned > counter = 0;
+
+        const auto path = root / name;
+
+        std::error_code error;
+        std::filesystem::create_directories( path.parent_path(), error );
+
+        // Write to a temporary file first and rename it afterwards, so that other compiler processes sharing the cache
+        // never observe a partially written entry.
+        auto temporary = path;
+        temporary += ".tmp" + std::to_string( ::getpid() ) + "." + std::to_string( counter++ );
+
+        {
+            std::ofstream out( temporary, std::ios::binary );
+
+            if ( !out.write( data.data(), data.size() ) )
+            {
+                std::filesystem::remove( temporary, error );
+                return;
+            }
+        }
+
+        std::filesystem::rename( temporary, path, error );
+
+        if ( error )
+        {
+            std::filesystem::remove( temporary, error );
+            return;
+        }
+
+        std::lock_guard< std::mutex > lock( prune_mutex );
+
+        // Entries are only counted, the directory is walked once the cache looks full
+        size += data.size();
+
+        if ( !measured || size > max_size )
+            prune_entries();
+    }
+
+    void store::prune()
+    {
+        std::lock_guard< std::mutex > lock( prune_mutex );
+        prune_entries();
+    }
+
+    void store::prune_entries()
+    {
+        struct entry
+        {
+            std::filesystem::path path;
+            std::uintmax_t size;
+            std::filesystem::file_time_type time;
+        };
+
+        std::vector< entry > entries;
+        std::uintmax_t total_size = 0;
+
+        std::error_code error;
+        for ( auto it = std::filesystem::recursive_directory_iterator( root, error );
+              it != std::filesystem::recursive_directory_iterator();
+              it.increment( error ) )
+        {
+            if ( error )
+                break;
+
+            if ( !it->is_regular_file( error ) )
+                continue;
+
+            const auto file_size = it->file_size( error );
+            const auto time = it->last_write_time( error );
+
+            // Temporary files are renamed to their entry once they are written (see save)
+            if ( it->path().filename().string().find( ".tmp" ) != std::string::npos )
+            {
+                if ( time < std::filesystem::file_time_type::clock::now() - abandoned_age )
+                    std::filesystem::remove( it->path(), error );
+
+                continue;
+            }
+
+            entries.push_back( entry{ it->path(), file_size, time } );
+            total_size += file_size;
+        }
+
+        measured = true;
+        size = total_size;
+
+        if ( total_size <= max_size )
+            return;
+
+        const auto target = static_cast< std::uintmax_t >( static_cast< double >( max_size ) * low_water );
+
+        // Oldest entries first
+        std::sort(
+            entries.begin(), entries.end(), []( const entry& a, const entry& b ) { return a.time < b.time; } );
+
+        for ( const auto& entry : entries )
+        {
+            if ( total_size <= target )
+                break;
+
+            if ( std::filesystem::remove( entry.path, error ) )
+                total_size -= entry.size;
+        }
+
+        size = total_size;
+    }
+
+    std::filesystem::path store::get_default_directory()
+    {
+        if ( const char* xdg = std::getenv( "XDG_CACHE_HOME" ); xdg && *xdg )
+            return std::filesystem::path{ xdg } / "lorraine";
+
+        if ( const char* home = std::getenv( "HOME" ); home && *home )
+            return std::filesystem::path{ home } / ".cache" / "lorraine";
+
+        return std::filesystem::temp_directory_path() / "lorraine-cache";
+    }
+}  // namespace lorraine::cache
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lorraine::cache
+{
+    /// @brief A directory of cached build artifacts with a size limit. Entries are evicted in least recently used
+    /// order, where the modification time of an entry is its last use (it is refreshed on every hit).
+    class store final
+    {
+       public:
+        /// @brief Opens (and creates if needed) a cache directory
+        /// @param root The cache directory
+        /// @param max_size Maximum size of all entries in bytes
+        explicit store( const std::filesystem::path& root, std::uintmax_t max_size );
+
+        /// @brief Loads an entry from the cache and marks it as recently used
+        /// @param name Path of the entry relative to the cache directory
+        /// @return The contents of the entry or nullptr if it does not exist
+        std::unique_ptr< llvm::MemoryBuffer > load( const std::string& name );
+
+        /// @brief Stores an entry in the cache, evicting old entries if the cache grows past its size limit (see
+        /// prune). Failing to write an entry is not an error, the cache is simply not populated.
+        /// @param name Path of the entry relative to the cache directory
+        /// @param data The contents of the entry
+        void save( const std::string& name, llvm::StringRef data );
+
+        /// @brief Removes the least recently used entries until the cache fits into its size limit. The directory is
+        /// only walked on the first save and then once the saved entries fill the cache, entries are removed until
+        /// it is filled to low_water (of the limit) so that this is rare. Entries that are still being written (by
+        /// other processes as well) are never removed.
+        void prune();
+
+        /// @brief Gets the default location of the cache: $XDG_CACHE_HOME/lorraine or ~/.cache/lorraine
+        /// @return Cache directory
+        static std::filesystem::path get_default_directory();
+
+       private:
+        std::filesystem::path root;
+        std::uintmax_t max_size;
+
+        /// @brief Fraction of the size limit the cache is pruned to
+        static constexpr double low_water = 0.9;
+
+        /// @brief Temporary files of crashed compilers are removed once they are this old
+        static constexpr std::chrono::hours abandoned_age{ 1 };
+
+        /// @brief Size of the cache when it was measured last, plus the entries saved since (see prune)
+        std::uintmax_t size = 0;
+        bool measured = false;
+
+        std::mutex prune_mutex;
+
+        /// @brief Prunes the cache (see prune), the mutex is locked
+        void prune_entries();
+    };
+}  // namespace lorraine::cache
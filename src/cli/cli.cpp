@@ -1,21 +1,44 @@
 #include "cli.hpp"
 
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <llvm/Support/WithColor.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../build/batch.hpp"
+#include "../build/build.hpp"
+#include "../build/watch.hpp"
 #include "../compiler/compiler.hpp"
+#include "../daemon/protocol.hpp"
+#include "../daemon/server.hpp"
 #include "../utils/CLI11.hpp"
 #include "../utils/error.hpp"
 #include "../utils/utils.hpp"
 
 namespace lorraine::cli
 {
-    cli::cli( int argc, char* argv[] )
+    cli::cli( int argc, char* argv[], std::shared_ptr< compiler::session > shared )
         : argc( argc ),
           argv( argv ),
+          shared( shared ? shared : std::make_shared< compiler::session >() ),
+          forwarded( shared != nullptr ),
           app( "A multipurpose optimizing compiler for the Lua++ programming language", "lorraine" )
     {
-        app.add_option( "file", input_file, "Input file." );
-        app.add_option( "-o,--output", output_file, "Output file." );
+        app.set_version_flag( "--version", LORRAINE_VERSION );
+
+        app.add_option( "file", input_files, "Input files or response files ('@file')." );
+        app.add_option( "-o,--output", output_file, "Output file (output directory when compiling multiple files)." );
+        app.add_option( "-j,--jobs", jobs, "Number of files compiled in parallel (0: one per hardware thread)." );
         app.add_option( "-s,--stage", stage, "Terminates the compiler after the stage." );
         app.add_option( "--config", config_file, "Location of a compiler configuration file." );
+        app.add_flag( "-r,--run", run, "Runs the program with the JIT compiler instead of emitting output." );
 
         app.add_flag(
             "--detailedErrors",
@@ -35,6 +58,67 @@ namespace lorraine::cli
             cfg.get< std::string >( "pathToTypeDefinitions" ),
             "Sets the path to the type definitions directory." );
 
+        app.add_option(
+               "-O,--optimizationLevel",
+               cfg.get< int >( "optimizationLevel" ),
+               "Sets the optimization level (0-3)." )
+            ->check( CLI::Range( 0, 3 ) );
+        app.add_flag(
+            "--lazyCompilation",
+            cfg.get< bool >( "lazyCompilation" ),
+            "Compiles functions the first time they are called when running with the JIT." );
+        app.add_flag(
+            "--speculativeCompilation",
+            cfg.get< bool >( "speculativeCompilation" ),
+            "Compiles functions that are likely to be called on background threads when running with the JIT." );
+
+        app.add_option(
+            "--target",
+            cfg.get< std::string >( "target" ),
+            "Sets the target triple for object files (default: host)." );
+        app.add_option( "--cpu", cfg.get< std::string >( "cpu" ), "Sets the target CPU for object files." );
+        app.add_flag(
+            "--streaming",
+            cfg.get< bool >( "streaming" ),
+            "Compiles one top-level statement at a time, for huge generated files (the output is not cached)." );
+        app.add_flag(
+            "--parallelLexing",
+            cfg.get< bool >( "parallelLexing" ),
+            "Tokenizes huge files in chunks on all hardware threads." );
+
+        app.add_flag(
+            "--cache",
+            cfg.get< bool >( "cache" ),
+            "Caches compiled objects on disk and reuses them when the code did not change." );
+        app.add_option(
+            "--cacheDirectory",
+            cfg.get< std::string >( "cacheDirectory" ),
+            "Sets the cache directory (default: $XDG_CACHE_HOME/lorraine)." );
+        app.add_option(
+               "--cacheSize", cfg.get< int >( "cacheSize" ), "Sets the maximum size of the cache in megabytes." )
+            ->check( CLI::NonNegativeNumber );
+
+        app.add_flag(
+            "--daemon", daemon, "Stays resident and compiles command lines forwarded with '--connect'." );
+        app.add_flag(
+            "--connect",
+            connect,
+            "Compiles with a running daemon if there is one, otherwise compiles in this process." );
+        app.add_option(
+            "--socket", socket, "Sets the socket of the daemon (default: $XDG_RUNTIME_DIR/lorraine.sock)." );
+
+        build_command = app.add_subcommand( "build", "Incrementally builds all modules of a project directory." );
+        build_command->add_option( "directory", build_directory, "Project directory (default: current directory)." );
+        build_command->add_option( "-o,--output", output_file, "Output directory (default: <directory>/build)." );
+        build_command->add_option( "-s,--stage", stage, "Stage to compile modules to (type, ir, codegen or object)." );
+        build_command->fallthrough();
+
+        watch_command = app.add_subcommand( "watch", "Builds a project directory and rebuilds it on every change." );
+        watch_command->add_option( "directory", build_directory, "Project directory (default: current directory)." );
+        watch_command->add_option( "-o,--output", output_file, "Output directory (default: <directory>/build)." );
+        watch_command->add_option( "-s,--stage", stage, "Stage to compile modules to (type, ir, codegen or object)." );
+        watch_command->fallthrough();
+
         app.callback( [ & ]() { callback(); } );
     }
 
@@ -43,21 +127,54 @@ namespace lorraine::cli
         if ( !config_file.empty() )
             cfg = config::load( config_file );
 
-        source = get_input();
+        expand_response_files();
+
+        if ( input_files.size() == 1 )
+            input_file = input_files.front();
+
+        // Projects and batches read their modules themselves, the daemon does not compile anything itself
+        if ( !daemon && !*build_command && !*watch_command && input_files.size() <= 1 )
+            read_input();
 
         std::locale::global( std::locale( cfg.get< std::string >( "locale" ) ) );
     }
 
-    std::string cli::get_input()
+    void cli::expand_response_files()
     {
-        // FileError
-        if ( input_file.empty() )
-            return utils::io::read_console();
+        std::vector< std::string > files;
+
+        for ( const auto& argument : input_files )
+        {
+            if ( argument.size() < 2 || argument.front() != '@' )
+            {
+                files.push_back( argument );
+                continue;
+            }
+
+            const auto content = utils::io::read_file( argument.substr( 1 ) );
+
+            if ( !content )
+                throw CLI::FileError::Missing( argument.substr( 1 ) );
 
-        if ( const auto content = utils::io::read_file( input_file ) )
-            return *content;
+            std::stringstream stream( *content );
 
-        throw CLI::FileError::Missing( input_file );
+            for ( std::string file; stream >> file; )
+                files.push_back( file );
+        }
+
+        input_files = std::move( files );
+    }
+
+    void cli::read_input()
+    {
+        if ( input_file.empty() )
+            input = llvm::MemoryBuffer::getMemBufferCopy( utils::io::read_console(), "stdin" );
+        else if ( auto buffer = llvm::MemoryBuffer::getFile( input_file ) )
+            input = std::move( *buffer );
+        else
+            throw CLI::FileError::Missing( input_file );
+
+        source = std::string_view{ input->getBufferStart(), input->getBufferSize() };
     }
 
     int cli::parse()
@@ -71,35 +188,152 @@ namespace lorraine::cli
             return app.exit( e );
         }
 
-        compiler::compiler compiler( cfg );
+        if ( daemon )
+            return serve();
+
+        compiler::compiler compiler( cfg, shared );
+
+        if ( *build_command || *watch_command )
+            return build( compiler );
+
+        if ( input_files.size() > 1 )
+            return batch();
 
         std::string name = input_file.empty() ? "stdin" : input_file;
-        std::string output = compiler.compile( name, source, get_stage() ).str();
 
-        if ( output_file.empty() )
-            std::cout << output;
-        else
+        if ( run )
+            return forwarded ? run_isolated( compiler, name ) : compiler.run( name, source );
+
+        // The output is streamed straight into the file (or stdout), which is removed again if compilation fails
+        std::error_code error;
+        llvm::ToolOutputFile out( output_file.empty() ? "-" : output_file, error, llvm::sys::fs::OF_None );
+
+        if ( error )
         {
-            std::ofstream out( output_file, std::ios::binary );
-            out << output;
+            llvm::WithColor::error() << "unable to open '" << output_file << "': " << error.message() << '\n';
+            return 1;
         }
 
+        if ( !compiler.compile( name, source, get_stage(), out.os() ) )
+            return 1;
+
+        out.keep();
+
         return 0;
     }
 
+    int cli::build( compiler::compiler& compiler )
+    {
+        const auto stage = get_stage();
+
+        if ( stage == compiler::compiler_stage::lexer || stage == compiler::compiler_stage::parser )
+            throw CLI::InvalidError( "Projects can only be built to the type, ir, codegen or object stage" );
+
+        const std::filesystem::path directory{ build_directory };
+        const std::filesystem::path output =
+            output_file.empty() ? directory / "build" : std::filesystem::path{ output_file };
+
+        build::project project{ compiler, directory, output, stage };
+
+        if ( *watch_command )
+        {
+            // It would never return, the daemon would not serve anyone else (see daemon::client::forward)
+            if ( forwarded )
+                throw CLI::InvalidError( "The daemon can not watch a project, run 'watch' without '--connect'" );
+
+            build::watcher watcher{ project };
+            return watcher.run();
+        }
+
+        return project.build();
+    }
+
+    int cli::batch()
+    {
+        const auto stage = get_stage();
+
+        if ( run )
+            throw CLI::InvalidError( "Only a single file can be run" );
+
+        if ( stage == compiler::compiler_stage::lexer || stage == compiler::compiler_stage::parser )
+            throw CLI::InvalidError( "Multiple files can only be compiled to the type, ir, codegen or object stage" );
+
+        build::batch batch{ cfg, output_file, stage, jobs, shared };
+
+        return batch.compile( input_files );
+    }
+
+    int cli::serve()
+    {
+        if ( forwarded )
+            throw CLI::InvalidError( "The daemon can not be started from a forwarded command line" );
+
+        daemon::server server{ socket.empty() ? daemon::get_default_socket() : std::filesystem::path{ socket } };
+
+        return server.run();
+    }
+
+    int cli::run_isolated( compiler::compiler& compiler, const std::string& name )
+    {
+        // Buffered output would be written by both processes otherwise
+        std::fflush( nullptr );
+        std::cout.flush();
+        std::cerr.flush();
+        llvm::outs().flush();
+        llvm::errs().flush();
+
+        const pid_t child = ::fork();
+
+        if ( child < 0 )
+        {
+            llvm::WithColor::error() << "unable to start the program: " << std::strerror( errno ) << '\n';
+            return 1;
+        }
+
+        if ( child == 0 )
+        {
+            int code = 1;
+
+            try
+            {
+                code = compiler.run( name, source );
+            }
+            catch ( const std::exception& e )
+            {
+                llvm::WithColor::error() << e.what() << '\n';
+            }
+
+            // Exits without running the destructors of the daemon's state, the program may not even have returned
+            std::fflush( nullptr );
+            std::cout.flush();
+            std::cerr.flush();
+            llvm::outs().flush();
+            llvm::errs().flush();
+            std::_Exit( code );
+        }
+
+        int status = 0;
+
+        while ( ::waitpid( child, &status, 0 ) < 0 && errno == EINTR )
+        {
+        }
+
+        if ( WIFSIGNALED( status ) )
+        {
+            llvm::WithColor::error() << "the program was terminated by signal " << WTERMSIG( status ) << '\n';
+            return 128 + WTERMSIG( status );
+        }
+
+        return WEXITSTATUS( status );
+    }
+
     compiler::compiler_stage cli::get_stage()
     {
         const auto it = stage_map.find( stage );
         if ( it != stage_map.end() )
             return it->second;
 
-        throw CLI::InvalidError( "Unknown compiler stage, possible stages: lexer, parser, type, ir, and codegen" );
+        throw CLI::InvalidError(
+            "Unknown compiler stage, possible stages: lexer, parser, type, ir, codegen, and object" );
     }
 }  // namespace lorraine::cli
-
-int main( int argc, char* argv[] )
-{
-    lorraine::cli::cli cli{ argc, argv };
-
-    return cli.parse();
-}
\ No newline at end of file
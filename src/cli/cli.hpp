@@ -1,9 +1,12 @@
 #pragma once
 
+#include <llvm/Support/MemoryBuffer.h>
+
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <filesystem>
+#include <vector>
 
 #include "../compiler/compiler.hpp"
 #include "../utils/CLI11.hpp"
@@ -17,7 +20,9 @@ namespace lorraine::cli
         /// @brief Creates a new command line interface
         /// @param argc The number of values in argv
         /// @param argv The array of arguments
-        explicit cli( int argc, char* argv[] );
+        /// @param shared Session shared with earlier compilations (e.g. by the daemon), a new one is created if none
+        /// is given
+        explicit cli( int argc, char* argv[], std::shared_ptr< compiler::session > shared = nullptr );
 
         /// @brief Parses the command line arguments
         /// @return 1 for success 0 for failure
@@ -27,18 +32,52 @@ namespace lorraine::cli
         CLI::App app;
         config cfg;
 
+        std::shared_ptr< compiler::session > shared;
+
+        /// @brief Set if the command line was forwarded to a daemon
+        bool forwarded;
+
         int argc;
         char** argv;
 
-        std::string source;
+        /// @brief The input, files are mapped into memory so that huge sources are only read as they are compiled
+        std::unique_ptr< llvm::MemoryBuffer > input;
+        std::string_view source;
 
         std::string input_file, output_file, stage = "codegen";
         std::string config_file;
 
+        /// @brief Input files and response files ('@file'). More than one file compiles them as a batch.
+        std::vector< std::string > input_files;
+        unsigned jobs = 1;
+
+        bool run = false;
+
+        /// @brief Stays resident and compiles command lines forwarded by clients ('--connect')
+        bool daemon = false, connect = false;
+        std::string socket;
+
+        /// @brief Builds a whole project directory instead of a single file (once or on every change)
+        CLI::App* build_command = nullptr;
+        CLI::App* watch_command = nullptr;
+        std::string build_directory = ".";
+
         void callback();
+        int build( compiler::compiler& compiler );
+        int batch();
+        int serve();
+
+        /// @brief Runs the program in a child process, so that a daemon survives it exiting or crashing and keeps
+        /// its working directory and descriptors (see daemon::server::execute)
+        /// @return The exit code of the program, 128 plus the signal if one terminated it
+        int run_isolated( compiler::compiler& compiler, const std::string& name );
+
+        /// @brief Replaces response files in the input files with the files they list (separated by whitespace)
+        void expand_response_files();
         compiler::compiler_stage get_stage();
         
-        std::string get_input();
+        /// @brief Reads the input file, or a line from the console if no file was given
+        void read_input();
 
         std::unordered_map< std::string_view, compiler::compiler_stage > stage_map = {
             { "lexer", compiler::compiler_stage::lexer },
@@ -46,6 +85,7 @@ namespace lorraine::cli
             { "type", compiler::compiler_stage::type },
             { "ir", compiler::compiler_stage::ir },
             { "codegen", compiler::compiler_stage::codegen },
+            { "object", compiler::compiler_stage::object },
         };
     };
 }  // namespace lorraine::cli
\ No newline at end of file
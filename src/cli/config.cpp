@@ -49,6 +49,11 @@ namespace lorraine::cli
                 throw CLI::ConfigError(
                     item + ": option value type mismatch; refer to configuration manual" );
             }
+            catch ( const std::invalid_argument& e )
+            {
+                throw CLI::ConfigError(
+                    item + ": option value type mismatch; refer to configuration manual" );
+            }
         }
 
         in.close();
@@ -59,6 +64,8 @@ namespace lorraine::cli
     {
         if ( value == "true" || value == "false" )
             get< bool >( name ) = value == "true";
+        else if ( options.at( name ).holds< int >() )
+            get< int >( name ) = std::stoi( value );
         else
         {
             get< std::string >( name ) = value;
@@ -23,8 +23,14 @@ namespace lorraine::cli
             return std::get< T >( value );
         }
 
+        template< typename T >
+        bool holds() const
+        {
+            return std::holds_alternative< T >( value );
+        }
+
        private:
-        std::variant< bool, std::string > value;
+        std::variant< bool, int, std::string > value;
     };
 
     class config final
@@ -56,7 +62,23 @@ namespace lorraine::cli
             // Compiler flags (affect behavior of language)
             { "imbalancedLocalAssignments", option_value{ true } },
             { "allowTypelessFunctions", option_value{ false } },
-            { "pathToTypeDefinitions", option_value{ "types" } }
+            { "pathToTypeDefinitions", option_value{ "types" } },
+
+            // Optimization and JIT flags
+            { "optimizationLevel", option_value{ 0 } },
+            { "lazyCompilation", option_value{ true } },
+            { "speculativeCompilation", option_value{ false } },
+
+            // Code generation flags
+            { "target", option_value{ "" } },
+            { "cpu", option_value{ "generic" } },
+            { "streaming", option_value{ false } },
+            { "parallelLexing", option_value{ false } },
+
+            // Build cache flags
+            { "cache", option_value{ false } },
+            { "cacheDirectory", option_value{ "" } },
+            { "cacheSize", option_value{ 1024 } }
         };
     };
 }  // namespace lorraine::cli
@@ -1,36 +1,158 @@
 #include "code_generation.hpp"
 
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/MDBuilder.h>
+
+#include <algorithm>
+#include <limits>
+
 #include "../utils/error.hpp"
 #include "llvm_visitor.hpp"
 
 namespace lorraine::code_generation
 {
-    std::shared_ptr< llvm::Module > code_generation::generate()
+    namespace
+    {
+        constexpr std::uint64_t fnv_offset = 0xcbf29ce484222325, fnv_prime = 0x100000001b3;
+
+        /// @brief Bytes that are 0x01 (or 0x80) in every byte of a group of control bytes
+        constexpr std::uint64_t low_bits = 0x0101010101010101, high_bits = 0x8080808080808080;
+
+        /// @brief The control byte of a free slot, full slots have the low 7 bits of the hash of their name
+        constexpr std::uint8_t empty_slot = 0x80;
+
+        /// @brief Hashes the name of a property (FNV-1a), like the function get_hash_function creates does
+        std::uint64_t hash( const std::string& name )
+        {
+            std::uint64_t h = fnv_offset;
+
+            for ( const unsigned char c : name )
+                h = ( h ^ c ) * fnv_prime;
+
+            return h;
+        }
+
+        /// @brief Reads the conversions of a printf format string
+        /// @return For each argument the format converts, in order, if it is converted as a double. The arguments
+        /// after an unknown conversion are not in it.
+        std::vector< bool > get_conversions( llvm::StringRef format )
+        {
+            std::vector< bool > conversions;
+
+            for ( std::size_t i = format.find( '%' ); i < format.size(); i = format.find( '%', i ) )
+            {
+                if ( format.substr( i + 1 ).startswith( "%" ) )
+                {
+                    i += 2;
+                    continue;
+                }
+
+                // Flags, the width and the precision, which can be arguments too
+                i = format.find_first_not_of( "-+ #0'", i + 1 );
+
+                for ( const bool precision : { false, true } )
+                {
+                    if ( precision && !format.substr( i ).startswith( "." ) )
+                        break;
+
+                    if ( precision )
+                        ++i;
+
+                    if ( format.substr( i ).startswith( "*" ) )
+                    {
+                        conversions.push_back( false );
+                        ++i;
+                    }
+                    else
+                        i = format.find_first_not_of( "0123456789", i );
+                }
+
+                i = format.find_first_not_of( "hlLqjzt", i );
+
+                if ( i >= format.size() )
+                    break;
+
+                if ( llvm::StringRef( "aAeEfFgG" ).contains( format[ i ] ) )
+                    conversions.push_back( true );
+                else if ( llvm::StringRef( "diouxXcspn" ).contains( format[ i ] ) )
+                    conversions.push_back( false );
+                else
+                    break;  // Positional arguments too, their '$' ends up here
+            }
+
+            return conversions;
+        }
+    }  // namespace
+
+    std::unique_ptr< llvm::Module > code_generation::generate()
+    {
+        for ( const auto& statement : ast_module->body->body )
+            generate( statement.get() );
+
+        return finish();
+    }
+
+    void code_generation::generate( ast::statement* statement )
     {
         // Collect external functions
         llvm_collector collector;
-        ast_module->body->visit( &collector );
+        statement->visit( &collector );
 
         // Compile external function declerations
         for ( const auto func : collector.external_declerations )
             compile_external_decleration( func );
 
-        const auto type = llvm::FunctionType::get( llvm::Type::getVoidTy( context ), false );
+        create_entry_function();
+
+        // Visit AST statement
+        llvm_visitor visitor( builder, *this );
+        statement->visit( &visitor );
+    }
 
-        const auto entry_function =
-            llvm::Function::Create( type, llvm::GlobalValue::ExternalLinkage, "main", *llvm_module );
+    std::unique_ptr< llvm::Module > code_generation::finish()
+    {
+        create_entry_function();
 
-        const auto entry_block = llvm::BasicBlock::Create( context, "entry", entry_function );
+        builder.CreateRetVoid();
 
-        llvm::IRBuilder<> builder( entry_block );
+        return std::move( llvm_module );
+    }
 
-        // Visit AST body
-        llvm_visitor visitor( builder, *this );
-        ast_module->visit( &visitor );
+    void code_generation::create_shape_types()
+    {
+        const auto get = [ this ]( const char* name, llvm::ArrayRef< llvm::Type* > elements )
+        {
+            if ( const auto type = llvm::StructType::getTypeByName( context, name ) )
+                return type;
 
-        builder.CreateRetVoid();
+            return llvm::StructType::create( context, elements, name );
+        };
+
+        auto* size_type = llvm::Type::getInt64Ty( context );
+
+        shape_entry_type = get(
+            "shape.entry",
+            { llvm::Type::getInt8PtrTy( context ), size_type, size_type, size_type, size_type, size_type } );
+        shape_type = get(
+            "shape",
+            { size_type,
+              shape_entry_type->getPointerTo(),
+              size_type,
+              size_type->getPointerTo(),
+              llvm::Type::getInt32PtrTy( context ) } );
+        cache_entry_type = get( "cache.entry", { shape_type->getPointerTo(), shape_entry_type->getPointerTo() } );
+    }
+
+    void code_generation::create_entry_function()
+    {
+        if ( entry_function )
+            return;
+
+        const auto type = llvm::FunctionType::get( llvm::Type::getVoidTy( context ), false );
+
+        entry_function = llvm::Function::Create( type, llvm::GlobalValue::ExternalLinkage, "main", *llvm_module );
 
-        return llvm_module;
+        builder.SetInsertPoint( llvm::BasicBlock::Create( context, "entry", entry_function ) );
     }
 
     llvm::Function* code_generation::get_or_create_function( std::shared_ptr< ast::variable > variable, bool external )
@@ -55,6 +177,1520 @@ namespace lorraine::code_generation
             throw utils::compiler_error( "Invalid function type" );
     }
 
+    llvm::Constant* code_generation::get_string( const std::string& value )
+    {
+        auto& string = strings[ value ];
+
+        if ( !string )
+            string = builder.CreateGlobalStringPtr( value, ".str", 0, llvm_module.get() );
+
+        return string;
+    }
+
+    llvm::Value* code_generation::compare_strings( llvm::Value* left, llvm::Value* right )
+    {
+        const auto strcmp = llvm_module->getOrInsertFunction(
+            "strcmp",
+            llvm::FunctionType::get(
+                builder.getInt32Ty(), { builder.getInt8PtrTy(), builder.getInt8PtrTy() }, false ) );
+
+        return builder.CreateCall( strcmp, { left, right } );
+    }
+
+    llvm::Value* code_generation::concat( llvm::Value* left, llvm::Value* right )
+    {
+        auto* size_type = builder.getInt64Ty();
+        auto* string_type = builder.getInt8PtrTy();
+
+        const auto strlen = llvm_module->getOrInsertFunction(
+            "strlen", llvm::FunctionType::get( size_type, { string_type }, false ) );
+        const auto malloc = llvm_module->getOrInsertFunction(
+            "malloc", llvm::FunctionType::get( string_type, { size_type }, false ) );
+
+        llvm::Value* left_length = builder.CreateCall( strlen, { left } );
+        llvm::Value* right_length = builder.CreateCall( strlen, { right } );
+        llvm::Value* length = builder.CreateAdd( left_length, right_length );
+
+        llvm::Value* string = builder.CreateCall( malloc, { builder.CreateAdd( length, builder.getInt64( 1 ) ) } );
+
+        // The terminator of the right string is copied with it
+        builder.CreateMemCpy( string, llvm::MaybeAlign( 1 ), left, llvm::MaybeAlign( 1 ), left_length );
+        builder.CreateMemCpy(
+            builder.CreateInBoundsGEP( builder.getInt8Ty(), string, left_length ),
+            llvm::MaybeAlign( 1 ),
+            right,
+            llvm::MaybeAlign( 1 ),
+            builder.CreateAdd( right_length, builder.getInt64( 1 ) ) );
+
+        return string;
+    }
+
+    llvm::Value* code_generation::create_array( llvm::StructType* type, const std::vector< llvm::Value* >& elements )
+    {
+        auto* element_type = type->getElementType( 2 )->getPointerElementType();
+        auto* size_type = llvm::Type::getInt64Ty( context );
+
+        const auto length = llvm::ConstantInt::get( size_type, elements.size() );
+
+        std::vector< llvm::Value* > values;
+        std::vector< llvm::Constant* > constants;
+
+        for ( const auto element : elements )
+        {
+            values.push_back( convert( element, element_type ) );
+
+            if ( const auto constant = llvm::dyn_cast< llvm::Constant >( values.back() ) )
+                constants.push_back( constant );
+        }
+
+        // Constant elements are static data, the array does not own them (its capacity is zero)
+        if ( constants.size() == elements.size() )
+        {
+            auto* data_type = llvm::ArrayType::get( element_type, elements.size() );
+            auto* data = new llvm::GlobalVariable(
+                *llvm_module,
+                data_type,
+                true,
+                llvm::GlobalValue::PrivateLinkage,
+                llvm::ConstantArray::get( data_type, constants ),
+                ".array" );
+
+            data->setUnnamedAddr( llvm::GlobalValue::UnnamedAddr::Global );
+
+            llvm::Constant* zero = llvm::ConstantInt::get( size_type, 0 );
+            llvm::Constant* indices[] = { zero, zero };
+
+            return llvm::ConstantStruct::get(
+                type, { length, zero, llvm::ConstantExpr::getInBoundsGetElementPtr( data_type, data, indices ) } );
+        }
+
+        llvm::Value* data = allocate( element_type, elements.size() );
+
+        for ( std::size_t i = 0; i < elements.size(); ++i )
+            builder.CreateStore( values[ i ], builder.CreateConstInBoundsGEP1_64( element_type, data, i ) );
+
+        llvm::Value* array = llvm::UndefValue::get( type );
+        array = builder.CreateInsertValue( array, length, 0 );
+        array = builder.CreateInsertValue( array, length, 1 );
+
+        return builder.CreateInsertValue( array, data, 2 );
+    }
+
+    llvm::Value* code_generation::create_table(
+        ast::type::type& type, const std::unordered_map< std::string, llvm::Value* >& properties )
+    {
+        const auto& table = std::get< ast::type::descriptor::table >( type.value );
+        const auto layout = table.get_layout();
+
+        auto* struct_type = llvm::cast< llvm::StructType >( type.to_llvm_type( context )->getPointerElementType() );
+
+        std::vector< llvm::Value* > values;
+        std::vector< llvm::Constant* > constants;
+
+        // Every table points to the shape of its type
+        values.push_back( llvm::ConstantExpr::getBitCast( get_shape( type ), struct_type->getElementType( 0 ) ) );
+        constants.push_back( llvm::cast< llvm::Constant >( values.back() ) );
+
+        // The constructor decides which optional properties are present, so the mask is a constant
+        std::vector< std::uint8_t > mask( ( layout.optional_count + 7 ) / 8 );
+
+        for ( std::size_t field = 0; field < layout.fields.size(); ++field )
+        {
+            const auto property = layout.fields[ field ];
+            const auto it = properties.find( table.properties[ property ].name );
+            auto* field_type = struct_type->getElementType( field + 1 );
+
+            if ( it != properties.end() )
+            {
+                values.push_back( convert( it->second, field_type ) );
+
+                if ( const auto bit = layout.bit_of[ property ] )
+                    mask[ *bit / 8 ] |= 1 << ( *bit % 8 );
+            }
+            else
+                values.push_back( llvm::Constant::getNullValue( field_type ) );
+
+            if ( const auto constant = llvm::dyn_cast< llvm::Constant >( values.back() ) )
+                constants.push_back( constant );
+        }
+
+        if ( layout.optional_count > 0 )
+        {
+            values.push_back( llvm::ConstantDataArray::get( context, mask ) );
+            constants.push_back( llvm::ConstantDataArray::get( context, mask ) );
+        }
+
+        if ( constants.size() == values.size() )
+        {
+            auto* constant = new llvm::GlobalVariable(
+                *llvm_module,
+                struct_type,
+                true,
+                llvm::GlobalValue::PrivateLinkage,
+                llvm::ConstantStruct::get( struct_type, constants ),
+                ".table" );
+
+            constant->setUnnamedAddr( llvm::GlobalValue::UnnamedAddr::Global );
+
+            return constant;
+        }
+
+        llvm::Value* result = allocate( struct_type, 1 );
+
+        for ( std::size_t i = 0; i < values.size(); ++i )
+            builder.CreateStore( values[ i ], builder.CreateStructGEP( struct_type, result, i ) );
+
+        return result;
+    }
+
+    llvm::Value* code_generation::get_length( llvm::Value* array )
+    {
+        // The length of an array that was just created is known
+        if ( const auto known = llvm::FindInsertedValue( array, 0 ) )
+            return known;
+
+        // Arrays have less elements than there are bytes in the address space
+        llvm::Value* length = builder.CreateExtractValue( array, 0, "length" );
+        set_range( length, { 0, ( std::int64_t( 1 ) << 48 ) - 1 } );
+
+        return length;
+    }
+
+    llvm::Value* code_generation::get_element( llvm::Value* array, llvm::Value* index )
+    {
+        auto* array_type = llvm::cast< llvm::StructType >( array->getType() );
+        auto* element_type = array_type->getElementType( 2 )->getPointerElementType();
+
+        // A boxed index has to be a number
+        if ( is_box( index ) )
+            index = unbox( index, builder.getDoubleTy() );
+
+        // A number that is not lowered to an integer has to be one. The conversion saturates, as NaN or numbers out
+        // of the range of i64 would have no value otherwise.
+        if ( index->getType()->isDoubleTy() )
+        {
+            llvm::Value* integer = builder.CreateIntrinsic(
+                llvm::Intrinsic::fptosi_sat, { builder.getInt64Ty(), index->getType() }, { index } );
+            check( builder.CreateFCmpOEQ( builder.CreateSIToFP( integer, index->getType() ), index ), "index" );
+
+            index = integer;
+        }
+        else
+            index = convert( index, builder.getInt64Ty() );
+
+        llvm::Value* length = get_length( array );
+        llvm::Value* offset = builder.CreateSub( index, builder.getInt64( 1 ) );
+
+        // The check is left out if the ranges of the index and the length prove it. Indices start at 1, so index 0
+        // wraps around to the largest offset, which is never in bounds.
+        const auto range = get_range( index );
+
+        if ( !is_integer( index ) || range.min < 1 || range.max > get_range( length ).min )
+            check( builder.CreateICmpULT( offset, length ), "bounds" );
+
+        llvm::Value* elements = builder.CreateExtractValue( array, 2 );
+        return builder.CreateLoad( element_type, builder.CreateInBoundsGEP( element_type, elements, offset ) );
+    }
+
+    llvm::Value* code_generation::get_property( llvm::Value* table, ast::type::type& type, const std::string& name )
+    {
+        const auto property = *std::get< ast::type::descriptor::table >( type.value ).get_index( name );
+
+        llvm::Value* value = load_field( table, type, property );
+
+        if ( llvm::Value* present = is_present( table, type, property ) )
+            return builder.CreateSelect( present, box( value ), get_nil() );
+
+        return value;
+    }
+
+    llvm::Value* code_generation::convert_table( llvm::Value* table, ast::type::type& from, ast::type::type& to )
+    {
+        if ( from.to_string() == to.to_string() )
+            return table;
+
+        const auto& source = std::get< ast::type::descriptor::table >( from.value );
+        const auto& target = std::get< ast::type::descriptor::table >( to.value );
+        const auto layout = target.get_layout();
+
+        auto* struct_type = llvm::cast< llvm::StructType >( to.to_llvm_type( context )->getPointerElementType() );
+        llvm::Value* result = allocate( struct_type, 1 );
+
+        builder.CreateStore(
+            llvm::ConstantExpr::getBitCast( get_shape( to ), struct_type->getElementType( 0 ) ),
+            builder.CreateStructGEP( struct_type, result, 0 ) );
+
+        std::vector< llvm::Value* > mask( ( layout.optional_count + 7 ) / 8, builder.getInt8( 0 ) );
+
+        for ( std::size_t property = 0; property < target.properties.size(); ++property )
+        {
+            const auto& name = target.properties[ property ].name;
+            const auto& type = target.properties[ property ].t;
+            const auto field = static_cast< unsigned >( layout.field_of[ property ] + 1 );
+            auto* field_type = struct_type->getElementType( field );
+
+            const auto index = source.get_index( name );
+
+            // Properties the value does not have are optional, they are absent
+            llvm::Value* value = llvm::Constant::getNullValue( field_type );
+            llvm::Value* present = builder.getInt1( index.has_value() );
+
+            if ( index )
+            {
+                auto& source_type = *source.properties[ *index ].t;
+
+                value = load_field( table, from, *index );
+
+                if ( llvm::Value* source_present = is_present( table, from, *index ) )
+                    present = source_present;
+
+                // Tables in properties are converted as well, if they are there
+                if ( std::holds_alternative< ast::type::descriptor::table >( type->value ) &&
+                     std::holds_alternative< ast::type::descriptor::table >( source_type.value ) &&
+                     type->to_string() != source_type.to_string() )
+                {
+                    llvm::Function* function = builder.GetInsertBlock()->getParent();
+                    auto* before = builder.GetInsertBlock();
+                    auto* nested = llvm::BasicBlock::Create( context, "convert", function );
+                    auto* done = llvm::BasicBlock::Create( context, "converted", function );
+
+                    builder.CreateCondBr( present, nested, done );
+
+                    builder.SetInsertPoint( nested );
+                    llvm::Value* converted = convert_table( value, source_type, *type );
+                    auto* after = builder.GetInsertBlock();
+                    builder.CreateBr( done );
+
+                    builder.SetInsertPoint( done );
+                    llvm::PHINode* phi = builder.CreatePHI( field_type, 2 );
+                    phi->addIncoming( llvm::Constant::getNullValue( field_type ), before );
+                    phi->addIncoming( converted, after );
+
+                    value = phi;
+                }
+                else
+                    value = convert( value, field_type );
+            }
+
+            builder.CreateStore( value, builder.CreateStructGEP( struct_type, result, field ) );
+
+            if ( const auto bit = layout.bit_of[ property ] )
+            {
+                auto& byte = mask[ *bit / 8 ];
+                byte = builder.CreateOr(
+                    byte, builder.CreateShl( builder.CreateZExt( present, builder.getInt8Ty() ), *bit % 8 ) );
+            }
+            else if ( !llvm::isa< llvm::Constant >( present ) )
+                check( present, "present" );  // The value had the property as an optional one
+        }
+
+        for ( std::size_t i = 0; i < mask.size(); ++i )
+        {
+            builder.CreateStore( mask[ i ], get_mask( result, i ) );
+        }
+
+        return result;
+    }
+
+    llvm::Value* code_generation::call_variadic( llvm::Function* function, std::vector< llvm::Value* > arguments )
+    {
+        const auto fixed = function->getFunctionType()->getNumParams();
+
+        llvm::StringRef format;
+        std::vector< bool > conversions;
+
+        if ( fixed > 0 && llvm::getConstantStringInfo( arguments[ fixed - 1 ], format ) )
+            conversions = get_conversions( format );
+
+        for ( std::size_t i = 0; i < conversions.size() && fixed + i < arguments.size(); ++i )
+        {
+            if ( !is_box( arguments[ fixed + i ] ) )
+                continue;
+
+            llvm::Value* bits = builder.CreateExtractValue( arguments[ fixed + i ], 0 );
+            llvm::Value* number = builder.CreateBitCast( bits, builder.getDoubleTy() );
+
+            if ( conversions[ i ] )
+                arguments[ fixed + i ] = number;
+            else
+                arguments[ fixed + i ] = builder.CreateSelect(
+                    has_type( bits, builder.getDoubleTy() ),
+                    builder.CreateFPToSI( number, builder.getInt64Ty() ),
+                    builder.CreateAnd( bits, builder.getInt64( payload_mask ) ) );
+        }
+
+        return fork_variadic( function, std::move( arguments ) );
+    }
+
+    llvm::Value* code_generation::fork_variadic( llvm::Function* function, std::vector< llvm::Value* > arguments )
+    {
+        const auto variadic = arguments.begin() + function->getFunctionType()->getNumParams();
+        const auto boxed =
+            std::find_if( variadic, arguments.end(), [ this ]( llvm::Value* value ) { return is_box( value ); } );
+
+        if ( boxed == arguments.end() )
+            return builder.CreateCall( function, arguments );
+
+        const auto index = static_cast< std::size_t >( boxed - arguments.begin() );
+        llvm::Value* bits = builder.CreateExtractValue( *boxed, 0 );
+
+        llvm::Function* parent = builder.GetInsertBlock()->getParent();
+        auto* number = llvm::BasicBlock::Create( context, "vararg.number", parent );
+        auto* other = llvm::BasicBlock::Create( context, "vararg.other", parent );
+        auto* done = llvm::BasicBlock::Create( context, "vararg.done", parent );
+
+        builder.CreateCondBr( has_type( bits, builder.getDoubleTy() ), number, other );
+
+        // The rest of the boxed arguments are passed the same way in both calls
+        builder.SetInsertPoint( number );
+        arguments[ index ] = builder.CreateBitCast( bits, builder.getDoubleTy() );
+        llvm::Value* number_result = fork_variadic( function, arguments );
+        auto* number_end = builder.GetInsertBlock();
+        builder.CreateBr( done );
+
+        builder.SetInsertPoint( other );
+        arguments[ index ] = builder.CreateAnd( bits, builder.getInt64( payload_mask ) );
+        llvm::Value* other_result = fork_variadic( function, arguments );
+        auto* other_end = builder.GetInsertBlock();
+        builder.CreateBr( done );
+
+        builder.SetInsertPoint( done );
+
+        if ( function->getReturnType()->isVoidTy() )
+            return number_result;
+
+        llvm::PHINode* result = builder.CreatePHI( number_result->getType(), 2 );
+        result->addIncoming( number_result, number_end );
+        result->addIncoming( other_result, other_end );
+
+        return result;
+    }
+
+    llvm::Value* code_generation::get_dynamic_property( llvm::Value* value, const std::string& name )
+    {
+        llvm::Value* object = get_object( value );
+        llvm::Value* shape = builder.CreateLoad(
+            shape_type->getPointerTo(), builder.CreateBitCast( object, shape_type->getPointerTo()->getPointerTo() ) );
+
+        auto* cache_type = llvm::ArrayType::get( cache_entry_type, cache_size );
+        auto* cache = new llvm::GlobalVariable(
+            *llvm_module,
+            cache_type,
+            false,
+            llvm::GlobalValue::InternalLinkage,
+            llvm::ConstantAggregateZero::get( cache_type ),
+            ".cache." + name );
+
+        llvm::Function* function = builder.GetInsertBlock()->getParent();
+        auto* done = llvm::BasicBlock::Create( context, "cache.done", function );
+
+        std::vector< std::pair< llvm::Value*, llvm::BasicBlock* > > hits;
+
+        // The shapes are compared in the order they were last seen, a site that only sees one hits the first
+        for ( unsigned i = 0; i < cache_size; ++i )
+        {
+            llvm::Value* slot = builder.CreateConstInBoundsGEP2_32( cache_type, cache, 0, i );
+            llvm::Value* cached =
+                builder.CreateLoad( shape_type->getPointerTo(), builder.CreateStructGEP( cache_entry_type, slot, 0 ) );
+
+            auto* hit = llvm::BasicBlock::Create( context, "cache.hit", function );
+            auto* next = llvm::BasicBlock::Create( context, "cache.next", function );
+
+            builder.CreateCondBr( builder.CreateICmpEQ( cached, shape ), hit, next );
+
+            builder.SetInsertPoint( hit );
+            hits.emplace_back(
+                builder.CreateLoad(
+                    shape_entry_type->getPointerTo(), builder.CreateStructGEP( cache_entry_type, slot, 1 ) ),
+                hit );
+            builder.CreateBr( done );
+
+            builder.SetInsertPoint( next );
+        }
+
+        hits.emplace_back(
+            builder.CreateCall(
+                get_lookup_function(), { shape, get_string( name ), builder.getInt64( hash( name ) ), cache } ),
+            builder.GetInsertBlock() );
+        builder.CreateBr( done );
+
+        builder.SetInsertPoint( done );
+        llvm::PHINode* entry = builder.CreatePHI( shape_entry_type->getPointerTo(), hits.size() );
+
+        for ( const auto& [ found, block ] : hits )
+            entry->addIncoming( found, block );
+
+        return builder.CreateCall( get_load_function(), { object, entry } );
+    }
+
+    llvm::Value* code_generation::get_dynamic_property( llvm::Value* value, llvm::Value* name )
+    {
+        llvm::Value* object = get_object( value );
+        llvm::Value* shape = builder.CreateLoad(
+            shape_type->getPointerTo(), builder.CreateBitCast( object, shape_type->getPointerTo()->getPointerTo() ) );
+
+        llvm::Value* key = convert( name, builder.getInt8PtrTy() );
+        llvm::Value* entry = builder.CreateCall(
+            get_lookup_function(),
+            { shape,
+              key,
+              builder.CreateCall( get_hash_function(), { key } ),
+              llvm::ConstantPointerNull::get(
+                  llvm::ArrayType::get( cache_entry_type, cache_size )->getPointerTo() ) } );
+
+        return builder.CreateCall( get_load_function(), { object, entry } );
+    }
+
+    llvm::Constant* code_generation::get_shape( ast::type::type& type )
+    {
+        const auto key = type.to_string();
+
+        if ( const auto it = shapes.find( key ); it != shapes.end() )
+            return it->second;
+
+        const auto& table = std::get< ast::type::descriptor::table >( type.value );
+        const auto layout = table.get_layout();
+
+        auto* struct_type = llvm::cast< llvm::StructType >( type.to_llvm_type( context )->getPointerElementType() );
+        auto* size_type = builder.getInt64Ty();
+
+        const auto offset_of = [ & ]( unsigned field, unsigned byte )
+        {
+            // A constant expression, the data layout is only known once the target is
+            llvm::Constant* indices[] = { builder.getInt32( 0 ), builder.getInt32( field ), builder.getInt32( byte ) };
+
+            return llvm::ConstantExpr::getPtrToInt(
+                llvm::ConstantExpr::getInBoundsGetElementPtr(
+                    struct_type,
+                    llvm::ConstantPointerNull::get( struct_type->getPointerTo() ),
+                    llvm::makeArrayRef( indices, byte == ~0u ? 2 : 3 ) ),
+                size_type );
+        };
+
+        std::vector< llvm::Constant* > entries;
+        std::vector< std::uint64_t > hashes;
+
+        for ( std::size_t property = 0; property < table.properties.size(); ++property )
+        {
+            const auto field = static_cast< unsigned >( layout.field_of[ property ] + 1 );
+            auto* field_type = struct_type->getElementType( field );
+
+            field_kind kind;
+
+            if ( field_type->isDoubleTy() )
+                kind = field_kind::number;
+            else if ( field_type->isIntegerTy( 1 ) )
+                kind = field_kind::boolean;
+            else if ( field_type == box_type )
+                kind = field_kind::any;
+            else if ( field_type->isPointerTy() && !field_type->getPointerElementType()->isFunctionTy() )
+                kind = get_tag( field_type ) == box_tag::string ? field_kind::string : field_kind::table;
+            else
+            {
+                // Values of this type cannot be boxed, through a value of any type the table has no such property
+                continue;
+            }
+
+            const auto bit = layout.bit_of[ property ];
+            const auto mask = struct_type->getNumElements() - 1;
+
+            entries.push_back( llvm::ConstantStruct::get(
+                shape_entry_type,
+                { get_string( table.properties[ property ].name ),
+                  llvm::ConstantInt::get( size_type, hash( table.properties[ property ].name ) ),
+                  offset_of( field, ~0u ),
+                  llvm::ConstantInt::get( size_type, static_cast< std::uint64_t >( kind ) ),
+                  bit ? offset_of( mask, static_cast< unsigned >( *bit / 8 ) ) : llvm::ConstantInt::get( size_type, 0 ),
+                  llvm::ConstantInt::get( size_type, bit ? static_cast< std::int64_t >( *bit % 8 ) : -1, true ) } ) );
+
+            hashes.push_back( hash( table.properties[ property ].name ) );
+        }
+
+        // The index of the entries is a hash table of groups of slots, with a control byte for every slot. Every
+        // lookup ends in a group with a free slot, and at most 7 of 8 slots are full.
+        std::size_t groups = 1;
+
+        while ( groups * ( group_size - 1 ) < entries.size() + 1 )
+            groups *= 2;
+
+        std::vector< std::uint8_t > control( groups * group_size, empty_slot );
+        std::vector< std::uint32_t > slots( groups * group_size );
+
+        for ( std::size_t i = 0; i < entries.size(); ++i )
+        {
+            // The groups are probed in triangular steps, which visit every group of a power of two
+            for ( std::size_t group = ( hashes[ i ] >> 7 ) & ( groups - 1 ), step = 1;;
+                  group = ( group + step++ ) & ( groups - 1 ) )
+            {
+                const auto first = control.begin() + group * group_size;
+                const auto free = std::find( first, first + group_size, empty_slot );
+
+                if ( free == first + group_size )
+                    continue;
+
+                *free = static_cast< std::uint8_t >( hashes[ i ] & 0x7f );
+                slots[ free - control.begin() ] = static_cast< std::uint32_t >( i );
+
+                break;
+            }
+        }
+
+        // The control bytes of a group are read as one word, the first slot is its lowest byte
+        std::vector< std::uint64_t > words( groups );
+
+        for ( std::size_t i = 0; i < control.size(); ++i )
+            words[ i / group_size ] |= std::uint64_t( control[ i ] ) << ( i % group_size * 8 );
+
+        const auto create_array = [ & ]( llvm::Constant* data, const char* name )
+        {
+            auto* global = new llvm::GlobalVariable(
+                *llvm_module, data->getType(), true, llvm::GlobalValue::PrivateLinkage, data, name );
+
+            return llvm::ConstantExpr::getInBoundsGetElementPtr(
+                data->getType(),
+                global,
+                llvm::ArrayRef< llvm::Constant* >{ builder.getInt32( 0 ), builder.getInt32( 0 ) } );
+        };
+
+        auto* entries_type = llvm::ArrayType::get( shape_entry_type, entries.size() );
+
+        auto* shape = new llvm::GlobalVariable(
+            *llvm_module,
+            shape_type,
+            true,
+            llvm::GlobalValue::PrivateLinkage,
+            llvm::ConstantStruct::get(
+                shape_type,
+                { llvm::ConstantInt::get( size_type, entries.size() ),
+                  create_array( llvm::ConstantArray::get( entries_type, entries ), ".shape.entries" ),
+                  llvm::ConstantInt::get( size_type, groups - 1 ),
+                  create_array( llvm::ConstantDataArray::get( context, words ), ".shape.control" ),
+                  create_array( llvm::ConstantDataArray::get( context, slots ), ".shape.slots" ) } ),
+            ".shape" );
+
+        return shapes[ key ] = shape;
+    }
+
+    llvm::Function* code_generation::get_lookup_function()
+    {
+        const auto name = "lorraine.shape.lookup";
+
+        if ( const auto function = llvm_module->getFunction( name ) )
+            return function;
+
+        auto* cache_type = llvm::ArrayType::get( cache_entry_type, cache_size );
+        auto* entry_pointer = shape_entry_type->getPointerTo();
+        auto* size_type = builder.getInt64Ty();
+
+        auto* function = llvm::Function::Create(
+            llvm::FunctionType::get(
+                entry_pointer,
+                { shape_type->getPointerTo(), builder.getInt8PtrTy(), size_type, cache_type->getPointerTo() },
+                false ),
+            llvm::GlobalValue::InternalLinkage,
+            name,
+            *llvm_module );
+
+        // Misses are rare, so they are not inlined into every access
+        function->addFnAttr( llvm::Attribute::NoInline );
+        function->addFnAttr( llvm::Attribute::Cold );
+
+        llvm::Value* shape = function->getArg( 0 );
+        llvm::Value* property = function->getArg( 1 );
+        llvm::Value* property_hash = function->getArg( 2 );
+        llvm::Value* cache = function->getArg( 3 );
+
+        const auto strcmp = llvm_module->getOrInsertFunction(
+            "strcmp",
+            llvm::FunctionType::get(
+                builder.getInt32Ty(), { builder.getInt8PtrTy(), builder.getInt8PtrTy() }, false ) );
+
+        llvm::IRBuilderBase::InsertPointGuard guard( builder );
+
+        auto* entry = llvm::BasicBlock::Create( context, "entry", function );
+        auto* probe = llvm::BasicBlock::Create( context, "probe", function );
+        auto* matches = llvm::BasicBlock::Create( context, "matches", function );
+        auto* candidate = llvm::BasicBlock::Create( context, "candidate", function );
+        auto* same_pointer = llvm::BasicBlock::Create( context, "same.pointer", function );
+        auto* same_name = llvm::BasicBlock::Create( context, "same.name", function );
+        auto* mismatch = llvm::BasicBlock::Create( context, "mismatch", function );
+        auto* group_end = llvm::BasicBlock::Create( context, "group.end", function );
+        auto* advance = llvm::BasicBlock::Create( context, "advance", function );
+        auto* found = llvm::BasicBlock::Create( context, "found", function );
+        auto* remember = llvm::BasicBlock::Create( context, "remember", function );
+        auto* end = llvm::BasicBlock::Create( context, "end", function );
+
+        builder.SetInsertPoint( entry );
+
+        const auto load = [ & ]( llvm::Type* type, unsigned field, const llvm::Twine& name )
+        { return builder.CreateLoad( type, builder.CreateStructGEP( shape_type, shape, field ), name ); };
+
+        llvm::Value* entries = load( entry_pointer, 1, "entries" );
+        llvm::Value* group_mask = load( size_type, 2, "group.mask" );
+        llvm::Value* control = load( size_type->getPointerTo(), 3, "control" );
+        llvm::Value* slots = load( builder.getInt32Ty()->getPointerTo(), 4, "slots" );
+
+        // The low 7 bits of the hash are looked for in all control bytes of a group at once, the rest picks the
+        // first group
+        llvm::Value* pattern = builder.CreateMul(
+            builder.CreateAnd( property_hash, builder.getInt64( 0x7f ) ), builder.getInt64( low_bits ) );
+        llvm::Value* start = builder.CreateAnd( builder.CreateLShr( property_hash, 7 ), group_mask );
+
+        builder.CreateBr( probe );
+
+        builder.SetInsertPoint( probe );
+
+        llvm::PHINode* group = builder.CreatePHI( size_type, 2, "group" );
+        llvm::PHINode* step = builder.CreatePHI( size_type, 2, "step" );
+        group->addIncoming( start, entry );
+        step->addIncoming( builder.getInt64( 1 ), entry );
+
+        llvm::Value* word =
+            builder.CreateLoad( size_type, builder.CreateInBoundsGEP( size_type, control, group ), "word" );
+
+        // A byte of the difference is zero where the control byte matches, this sets its high bit. It may set the
+        // ones of bytes after a match as well, every candidate is compared anyway.
+        llvm::Value* difference = builder.CreateXor( word, pattern );
+        llvm::Value* found_bits = builder.CreateAnd(
+            builder.CreateAnd(
+                builder.CreateSub( difference, builder.getInt64( low_bits ) ), builder.CreateNot( difference ) ),
+            builder.getInt64( high_bits ) );
+
+        builder.CreateBr( matches );
+
+        builder.SetInsertPoint( matches );
+
+        llvm::PHINode* bits = builder.CreatePHI( size_type, 2, "bits" );
+        bits->addIncoming( found_bits, probe );
+
+        builder.CreateCondBr( builder.CreateICmpEQ( bits, builder.getInt64( 0 ) ), group_end, candidate );
+
+        builder.SetInsertPoint( candidate );
+
+        llvm::Value* byte =
+            builder.CreateLShr( builder.CreateBinaryIntrinsic( llvm::Intrinsic::cttz, bits, builder.getTrue() ), 3 );
+        llvm::Value* slot = builder.CreateAdd( builder.CreateShl( group, 3 ), byte );
+        llvm::Value* index = builder.CreateZExt(
+            builder.CreateLoad( builder.getInt32Ty(), builder.CreateInBoundsGEP( builder.getInt32Ty(), slots, slot ) ),
+            size_type );
+        llvm::Value* found_entry = builder.CreateInBoundsGEP( shape_entry_type, entries, index );
+        bits->addIncoming( builder.CreateAnd( bits, builder.CreateSub( bits, builder.getInt64( 1 ) ) ), mismatch );
+
+        llvm::Value* entry_hash =
+            builder.CreateLoad( size_type, builder.CreateStructGEP( shape_entry_type, found_entry, 1 ), "hash" );
+        builder.CreateCondBr( builder.CreateICmpEQ( entry_hash, property_hash ), same_pointer, mismatch );
+
+        // Names are interned in a module, a name from another module is compared by its characters
+        builder.SetInsertPoint( same_pointer );
+
+        llvm::Value* entry_name = builder.CreateLoad(
+            builder.getInt8PtrTy(), builder.CreateStructGEP( shape_entry_type, found_entry, 0 ), "name" );
+        builder.CreateCondBr( builder.CreateICmpEQ( entry_name, property ), found, same_name );
+
+        builder.SetInsertPoint( same_name );
+        builder.CreateCondBr(
+            builder.CreateICmpEQ( builder.CreateCall( strcmp, { entry_name, property } ), builder.getInt32( 0 ) ),
+            found,
+            mismatch );
+
+        builder.SetInsertPoint( mismatch );
+        builder.CreateBr( matches );
+
+        // The property is not in the table if the group has a free slot, it would have been put there
+        builder.SetInsertPoint( group_end );
+        builder.CreateCondBr(
+            builder.CreateICmpNE( builder.CreateAnd( word, builder.getInt64( high_bits ) ), builder.getInt64( 0 ) ),
+            found,
+            advance );
+
+        builder.SetInsertPoint( advance );
+        group->addIncoming( builder.CreateAnd( builder.CreateAdd( group, step ), group_mask ), advance );
+        step->addIncoming( builder.CreateAdd( step, builder.getInt64( 1 ) ), advance );
+        builder.CreateBr( probe );
+
+        // Null if there is no such property
+        builder.SetInsertPoint( found );
+
+        llvm::PHINode* result = builder.CreatePHI( entry_pointer, 3, "result" );
+        result->addIncoming( llvm::ConstantPointerNull::get( entry_pointer ), group_end );
+        result->addIncoming( found_entry, same_pointer );
+        result->addIncoming( found_entry, same_name );
+
+        builder.CreateCondBr( builder.CreateIsNull( cache ), end, remember );
+
+        // The shapes that were seen before move back by one, the last one is forgotten
+        builder.SetInsertPoint( remember );
+
+        for ( unsigned i = cache_size - 1; i > 0; --i )
+        {
+            llvm::Value* previous = builder.CreateLoad(
+                cache_entry_type, builder.CreateConstInBoundsGEP2_32( cache_type, cache, 0, i - 1 ) );
+            builder.CreateStore( previous, builder.CreateConstInBoundsGEP2_32( cache_type, cache, 0, i ) );
+        }
+
+        llvm::Value* first = builder.CreateInsertValue(
+            builder.CreateInsertValue( llvm::UndefValue::get( cache_entry_type ), shape, 0 ), result, 1 );
+        builder.CreateStore( first, builder.CreateConstInBoundsGEP2_32( cache_type, cache, 0, 0 ) );
+        builder.CreateBr( end );
+
+        builder.SetInsertPoint( end );
+        builder.CreateRet( result );
+
+        return function;
+    }
+
+    llvm::Function* code_generation::get_hash_function()
+    {
+        const auto name = "lorraine.string.hash";
+
+        if ( const auto function = llvm_module->getFunction( name ) )
+            return function;
+
+        auto* function = llvm::Function::Create(
+            llvm::FunctionType::get( builder.getInt64Ty(), { builder.getInt8PtrTy() }, false ),
+            llvm::GlobalValue::InternalLinkage,
+            name,
+            *llvm_module );
+
+        llvm::Value* string = function->getArg( 0 );
+
+        llvm::IRBuilderBase::InsertPointGuard guard( builder );
+
+        auto* entry = llvm::BasicBlock::Create( context, "entry", function );
+        auto* loop = llvm::BasicBlock::Create( context, "loop", function );
+        auto* body = llvm::BasicBlock::Create( context, "body", function );
+        auto* end = llvm::BasicBlock::Create( context, "end", function );
+
+        builder.SetInsertPoint( entry );
+        builder.CreateBr( loop );
+
+        builder.SetInsertPoint( loop );
+
+        llvm::PHINode* character = builder.CreatePHI( builder.getInt8PtrTy(), 2, "character" );
+        llvm::PHINode* h = builder.CreatePHI( builder.getInt64Ty(), 2, "hash" );
+        character->addIncoming( string, entry );
+        h->addIncoming( builder.getInt64( fnv_offset ), entry );
+
+        llvm::Value* c = builder.CreateLoad( builder.getInt8Ty(), character );
+        builder.CreateCondBr( builder.CreateICmpEQ( c, builder.getInt8( 0 ) ), end, body );
+
+        builder.SetInsertPoint( body );
+        h->addIncoming(
+            builder.CreateMul(
+                builder.CreateXor( h, builder.CreateZExt( c, builder.getInt64Ty() ) ), builder.getInt64( fnv_prime ) ),
+            body );
+        character->addIncoming( builder.CreateConstInBoundsGEP1_64( builder.getInt8Ty(), character, 1 ), body );
+        builder.CreateBr( loop );
+
+        builder.SetInsertPoint( end );
+        builder.CreateRet( h );
+
+        return function;
+    }
+
+    llvm::Function* code_generation::get_load_function()
+    {
+        const auto name = "lorraine.shape.load";
+
+        if ( const auto function = llvm_module->getFunction( name ) )
+            return function;
+
+        auto* function = llvm::Function::Create(
+            llvm::FunctionType::get(
+                box_type, { builder.getInt8PtrTy(), shape_entry_type->getPointerTo() }, false ),
+            llvm::GlobalValue::InternalLinkage,
+            name,
+            *llvm_module );
+
+        // Inlined into every access, where the entry of a cache hit is loaded
+        function->addFnAttr( llvm::Attribute::AlwaysInline );
+
+        llvm::Value* object = function->getArg( 0 );
+        llvm::Value* entry = function->getArg( 1 );
+
+        llvm::IRBuilderBase::InsertPointGuard guard( builder );
+
+        auto* start = llvm::BasicBlock::Create( context, "entry", function );
+        auto* exists = llvm::BasicBlock::Create( context, "exists", function );
+        auto* optional = llvm::BasicBlock::Create( context, "optional", function );
+        auto* present = llvm::BasicBlock::Create( context, "present", function );
+        auto* absent = llvm::BasicBlock::Create( context, "absent", function );
+
+        builder.SetInsertPoint( start );
+        builder.CreateCondBr( builder.CreateIsNull( entry ), absent, exists );
+
+        const auto field = [ & ]( unsigned i, const llvm::Twine& name )
+        {
+            return builder.CreateLoad(
+                builder.getInt64Ty(), builder.CreateStructGEP( shape_entry_type, entry, i ), name );
+        };
+
+        builder.SetInsertPoint( exists );
+
+        llvm::Value* bit = field( 5, "bit" );
+        builder.CreateCondBr( builder.CreateICmpSLT( bit, builder.getInt64( 0 ) ), present, optional );
+
+        // Optional properties are only there if their bit in the mask is set
+        builder.SetInsertPoint( optional );
+
+        llvm::Value* mask = builder.CreateLoad(
+            builder.getInt8Ty(), builder.CreateInBoundsGEP( builder.getInt8Ty(), object, field( 4, "mask" ) ) );
+        llvm::Value* set = builder.CreateAnd(
+            builder.CreateLShr( mask, builder.CreateTrunc( bit, builder.getInt8Ty() ) ), builder.getInt8( 1 ) );
+
+        builder.CreateCondBr( builder.CreateICmpNE( set, builder.getInt8( 0 ) ), present, absent );
+
+        builder.SetInsertPoint( absent );
+        builder.CreateRet( get_nil() );
+
+        builder.SetInsertPoint( present );
+
+        llvm::Value* address = builder.CreateInBoundsGEP( builder.getInt8Ty(), object, field( 2, "offset" ) );
+        llvm::Value* kind = field( 3, "kind" );
+
+        auto* unknown = llvm::BasicBlock::Create( context, "unknown", function );
+        llvm::SwitchInst* kinds = builder.CreateSwitch( kind, unknown, 5 );
+
+        builder.SetInsertPoint( unknown );
+        builder.CreateUnreachable();
+
+        // Every kind is loaded as the type it is stored as and boxed
+        const std::pair< field_kind, llvm::Type* > types[] = {
+            { field_kind::number, builder.getDoubleTy() },
+            { field_kind::boolean, builder.getInt1Ty() },
+            { field_kind::string, builder.getInt8PtrTy() },
+            { field_kind::table, shape_type->getPointerTo()->getPointerTo() },
+            { field_kind::any, box_type },
+        };
+
+        for ( const auto& [ k, type ] : types )
+        {
+            auto* load = llvm::BasicBlock::Create( context, "load", function );
+            kinds->addCase( builder.getInt64( static_cast< std::uint64_t >( k ) ), load );
+
+            builder.SetInsertPoint( load );
+            builder.CreateRet(
+                box( builder.CreateLoad( type, builder.CreateBitCast( address, type->getPointerTo() ) ) ) );
+        }
+
+        return function;
+    }
+
+    llvm::Value* code_generation::get_object( llvm::Value* value )
+    {
+        llvm::Value* bits = builder.CreateExtractValue( box( value ), 0 );
+        check( builder.CreateICmpEQ(
+                   builder.CreateLShr( bits, 48 ), builder.getInt64( static_cast< std::uint64_t >( box_tag::table ) ) ),
+               "table" );
+
+        return builder.CreateIntToPtr(
+            builder.CreateAnd( bits, builder.getInt64( payload_mask ) ), builder.getInt8PtrTy() );
+    }
+
+    llvm::Value* code_generation::create_interface(
+        llvm::Value* value, ast::type::type& type, ast::type::type& interface )
+    {
+        auto& descriptor = std::get< ast::type::descriptor::interface >( interface.value );
+
+        // The copy outlives the variable the value was in
+        llvm::Value* copy = allocate( value->getType(), 1 );
+        builder.CreateStore( value, copy );
+
+        auto* fat_type = llvm::cast< llvm::StructType >( interface.to_llvm_type( context ) );
+        llvm::Value* fat = llvm::UndefValue::get( fat_type );
+        fat = builder.CreateInsertValue( fat, builder.CreateBitCast( copy, builder.getInt8PtrTy() ), 0 );
+
+        return builder.CreateInsertValue( fat, get_itable( type, descriptor ), 1 );
+    }
+
+    llvm::Value* code_generation::call_member(
+        llvm::Value* receiver,
+        ast::type::type& type,
+        const std::string& name,
+        const std::vector< llvm::Value* >& arguments )
+    {
+        llvm::Value* self = nullptr;
+        llvm::FunctionCallee callee;
+
+        if ( const auto interface = std::get_if< ast::type::descriptor::interface >( &type.value ) )
+        {
+            self = builder.CreateExtractValue( receiver, 0 );
+
+            const auto& properties = interface->properties;
+            const auto slot = std::find_if(
+                                  properties.begin(),
+                                  properties.end(),
+                                  [ & ]( const auto& property ) { return property.name == name; } ) -
+                              properties.begin();
+
+            // The itable of a value that was converted in view is a constant, its slot has the implementation
+            llvm::Value* itable = llvm::FindInsertedValue( receiver, { 1 } );
+            const auto global =
+                itable ? llvm::dyn_cast< llvm::GlobalVariable >( itable->stripPointerCasts() ) : nullptr;
+
+            if ( global && global->hasDefinitiveInitializer() )
+            {
+                callee = llvm::cast< llvm::Function >(
+                    global->getInitializer()->getAggregateElement( slot )->stripPointerCasts() );
+            }
+            else
+            {
+                const auto& member = properties[ slot ].t;
+                llvm::FunctionType* function_type;
+
+                if ( const auto function = std::get_if< ast::type::descriptor::function >( &member->value ) )
+                {
+                    auto* method_type = llvm::cast< llvm::FunctionType >( member->to_llvm_type( context ) );
+
+                    std::vector< llvm::Type* > parameters = { builder.getInt8PtrTy() };
+                    parameters.insert( parameters.end(), method_type->param_begin(), method_type->param_end() );
+
+                    function_type = llvm::FunctionType::get( method_type->getReturnType(), parameters, false );
+                }
+                else
+                    function_type =
+                        llvm::FunctionType::get( member->to_llvm_type( context ), { builder.getInt8PtrTy() }, false );
+
+                llvm::Value* implementation = builder.CreateLoad(
+                    builder.getInt8PtrTy(),
+                    builder.CreateConstInBoundsGEP1_64(
+                        builder.getInt8PtrTy(), builder.CreateExtractValue( receiver, 1 ), slot ) );
+
+                callee = llvm::FunctionCallee(
+                    function_type, builder.CreateBitCast( implementation, function_type->getPointerTo() ) );
+            }
+        }
+        else
+        {
+            // The type is known, the value is only stored for the call (and stays in a register once it is inlined)
+            llvm::IRBuilder<> entry( &builder.GetInsertBlock()->getParent()->getEntryBlock(),
+                                     builder.GetInsertBlock()->getParent()->getEntryBlock().begin() );
+
+            llvm::Value* slot = entry.CreateAlloca( receiver->getType() );
+            builder.CreateStore( receiver, slot );
+
+            self = builder.CreateBitCast( slot, builder.getInt8PtrTy() );
+            callee = get_member( type, name );
+        }
+
+        std::vector< llvm::Value* > values = { self };
+
+        for ( std::size_t i = 0; i < arguments.size(); ++i )
+            values.push_back( convert( arguments[ i ], callee.getFunctionType()->getParamType( i + 1 ) ) );
+
+        return builder.CreateCall( callee, values );
+    }
+
+    llvm::Constant* code_generation::get_itable( ast::type::type& type, ast::type::descriptor::interface& interface )
+    {
+        const auto key = type.to_string() + " " + interface.name;
+
+        if ( const auto it = itables.find( key ); it != itables.end() )
+            return it->second;
+
+        std::vector< llvm::Constant* > members;
+
+        for ( const auto& property : interface.properties )
+            members.push_back(
+                llvm::ConstantExpr::getBitCast( get_member( type, property.name ), builder.getInt8PtrTy() ) );
+
+        auto* itable_type = llvm::ArrayType::get( builder.getInt8PtrTy(), members.size() );
+        auto* itable = new llvm::GlobalVariable(
+            *llvm_module,
+            itable_type,
+            true,
+            llvm::GlobalValue::PrivateLinkage,
+            llvm::ConstantArray::get( itable_type, members ),
+            ".itable" );
+
+        return itables[ key ] = llvm::ConstantExpr::getInBoundsGetElementPtr(
+                   itable_type,
+                   itable,
+                   llvm::ArrayRef< llvm::Constant* >{ builder.getInt32( 0 ), builder.getInt32( 0 ) } );
+    }
+
+    llvm::Function* code_generation::get_member( ast::type::type& type, const std::string& name )
+    {
+        const auto array = std::get_if< ast::type::descriptor::array >( &type.value );
+
+        if ( !array )
+            throw utils::compiler_error( "values of type '" + type.to_string() + "' do not implement interfaces yet" );
+
+        const auto function_name = "lorraine.Array." + name + "." + type.to_string();
+
+        if ( const auto function = llvm_module->getFunction( function_name ) )
+            return function;
+
+        llvm::Type* result;
+
+        if ( name == "length" )
+            result = builder.getDoubleTy();
+        else if ( name == "toString" )
+            result = builder.getInt8PtrTy();
+        else
+            throw utils::compiler_error( "arrays have no member '" + name + "'" );
+
+        auto* function = llvm::Function::Create(
+            llvm::FunctionType::get( result, { builder.getInt8PtrTy() }, false ),
+            llvm::GlobalValue::InternalLinkage,
+            function_name,
+            *llvm_module );
+
+        if ( name == "toString" )
+        {
+            create_to_string( function, *array->t );
+            return function;
+        }
+
+        llvm::IRBuilderBase::InsertPointGuard guard( builder );
+        builder.SetInsertPoint( llvm::BasicBlock::Create( context, "entry", function ) );
+
+        auto* array_type = type.to_llvm_type( context );
+        llvm::Value* self = builder.CreateLoad(
+            array_type, builder.CreateBitCast( function->getArg( 0 ), array_type->getPointerTo() ) );
+
+        builder.CreateRet( convert( get_length( self ), result ) );
+
+        return function;
+    }
+
+    void code_generation::create_to_string( llvm::Function* function, ast::type::type& element )
+    {
+        auto* size_type = builder.getInt64Ty();
+        auto* string_type = builder.getInt8PtrTy();
+
+        const char* format;
+
+        if ( element.is( ast::type::type::primitive_type::number ) )
+            format = "%s%.14g";
+        else if ( element.is( ast::type::type::primitive_type::string ) ||
+                  element.is( ast::type::type::primitive_type::boolean ) )
+            format = "%s%s";
+        else
+        {
+            // Such arrays still implement the Array interface, the validator rejects calling it where the type of the
+            // elements is known. Where it is not (through an interface), the program traps.
+            llvm::IRBuilderBase::InsertPointGuard guard( builder );
+            builder.SetInsertPoint( llvm::BasicBlock::Create( context, "entry", function ) );
+
+            builder.CreateIntrinsic( llvm::Intrinsic::trap, {}, {} );
+            builder.CreateUnreachable();
+            return;
+        }
+
+        const auto snprintf = llvm_module->getOrInsertFunction(
+            "snprintf",
+            llvm::FunctionType::get( builder.getInt32Ty(), { string_type, size_type, string_type }, true ) );
+        const auto malloc = llvm_module->getOrInsertFunction(
+            "malloc", llvm::FunctionType::get( string_type, { size_type }, false ) );
+
+        llvm::IRBuilderBase::InsertPointGuard guard( builder );
+        builder.SetInsertPoint( llvm::BasicBlock::Create( context, "entry", function ) );
+
+        auto* array_type = llvm::StructType::get(
+            context, { size_type, size_type, element.to_llvm_type( context )->getPointerTo() } );
+        llvm::Value* self = builder.CreateLoad(
+            array_type, builder.CreateBitCast( function->getArg( 0 ), array_type->getPointerTo() ) );
+
+        llvm::Value* length = builder.CreateExtractValue( self, 0, "length" );
+        llvm::Value* data = builder.CreateExtractValue( self, 2, "data" );
+
+        // Calls a function for every element, with the sum of what it returned for the elements before it
+        const auto accumulate = [ & ]( llvm::Value* initial, const auto& body )
+        {
+            auto* before = builder.GetInsertBlock();
+            auto* loop = llvm::BasicBlock::Create( context, "loop", function );
+            auto* step = llvm::BasicBlock::Create( context, "step", function );
+            auto* done = llvm::BasicBlock::Create( context, "done", function );
+
+            builder.CreateBr( loop );
+            builder.SetInsertPoint( loop );
+
+            llvm::PHINode* index = builder.CreatePHI( size_type, 2, "index" );
+            llvm::PHINode* total = builder.CreatePHI( size_type, 2, "total" );
+            index->addIncoming( builder.getInt64( 0 ), before );
+            total->addIncoming( initial, before );
+
+            builder.CreateCondBr( builder.CreateICmpULT( index, length ), step, done );
+            builder.SetInsertPoint( step );
+
+            llvm::Type* element_type = data->getType()->getPointerElementType();
+            llvm::Value* element =
+                builder.CreateLoad( element_type, builder.CreateInBoundsGEP( element_type, data, index ) );
+
+            // The elements are separated by commas
+            llvm::Value* separator = builder.CreateSelect(
+                builder.CreateICmpEQ( index, builder.getInt64( 0 ) ), get_string( "" ), get_string( ", " ) );
+
+            if ( element->getType()->isIntegerTy( 1 ) )
+                element = builder.CreateSelect( element, get_string( "true" ), get_string( "false" ) );
+
+            index->addIncoming( builder.CreateAdd( index, builder.getInt64( 1 ) ), step );
+            total->addIncoming( builder.CreateAdd( total, body( total, separator, element ) ), step );
+
+            builder.CreateBr( loop );
+            builder.SetInsertPoint( done );
+
+            return total;
+        };
+
+        // The length of the string is measured first, then it is written. The braces take 2 characters.
+        llvm::Value* size = accumulate(
+            builder.getInt64( 2 ),
+            [ & ]( llvm::Value*, llvm::Value* separator, llvm::Value* element )
+            {
+                llvm::Value* written = builder.CreateCall(
+                    snprintf,
+                    { llvm::ConstantPointerNull::get( string_type ),
+                      builder.getInt64( 0 ),
+                      get_string( format ),
+                      separator,
+                      element } );
+
+                return builder.CreateSExt( written, size_type );
+            } );
+
+        llvm::Value* string =
+            builder.CreateCall( malloc, { builder.CreateAdd( size, builder.getInt64( 1 ) ) }, "string" );
+        builder.CreateStore( builder.getInt8( '{' ), string );
+
+        llvm::Value* end = accumulate(
+            builder.getInt64( 1 ),
+            [ & ]( llvm::Value* offset, llvm::Value* separator, llvm::Value* element )
+            {
+                llvm::Value* written = builder.CreateCall(
+                    snprintf,
+                    { builder.CreateInBoundsGEP( builder.getInt8Ty(), string, offset ),
+                      builder.CreateSub( size, offset ),
+                      get_string( format ),
+                      separator,
+                      element } );
+
+                return builder.CreateSExt( written, size_type );
+            } );
+
+        builder.CreateStore( builder.getInt8( '}' ), builder.CreateInBoundsGEP( builder.getInt8Ty(), string, end ) );
+        builder.CreateStore(
+            builder.getInt8( 0 ),
+            builder.CreateInBoundsGEP( builder.getInt8Ty(), string, builder.CreateAdd( end, builder.getInt64( 1 ) ) ) );
+
+        builder.CreateRet( string );
+    }
+
+    llvm::Value* code_generation::box( llvm::Value* value )
+    {
+        if ( is_box( value ) )
+            return value;
+
+        if ( is_integer( value ) )
+            value = builder.CreateSIToFP( value, builder.getDoubleTy() );
+
+        llvm::Type* type = value->getType();
+        llvm::Value* bits = nullptr;
+
+        if ( type->isDoubleTy() )
+        {
+            // NaNs are made the one NaN that is not the bits of another value
+            bits = builder.CreateSelect(
+                builder.CreateFCmpUNO( value, value ),
+                builder.getInt64( canonical_nan ),
+                builder.CreateBitCast( value, builder.getInt64Ty() ) );
+        }
+        else
+        {
+            llvm::Value* payload = nullptr;
+
+            if ( type->isIntegerTy( 1 ) )
+                payload = builder.CreateZExt( value, builder.getInt64Ty() );
+            else if ( type->isPointerTy() )
+                payload = builder.CreatePtrToInt( value, builder.getInt64Ty() );
+            else
+                throw utils::compiler_error( "values of this type cannot be boxed yet" );
+
+            // Pointers fit in the 48 bits below the tag. The tag is added, not or'ed: constant boxes of global
+            // pointers are relocations then.
+            bits = builder.CreateAdd( payload, builder.getInt64( get_tag_bits( get_tag( type ) ) ) );
+        }
+
+        return builder.CreateInsertValue( llvm::UndefValue::get( box_type ), bits, 0 );
+    }
+
+    llvm::Value* code_generation::unbox( llvm::Value* value, llvm::Type* type )
+    {
+        llvm::Value* bits = builder.CreateExtractValue( value, 0 );
+
+        check( has_type( bits, type ), "unbox" );
+
+        if ( type->isDoubleTy() )
+            return builder.CreateBitCast( bits, type );
+
+        llvm::Value* payload = builder.CreateAnd( bits, builder.getInt64( payload_mask ) );
+
+        if ( type->isIntegerTy( 1 ) )
+            return builder.CreateTrunc( payload, type );
+
+        return builder.CreateIntToPtr( payload, type );
+    }
+
+    llvm::Value* code_generation::convert( llvm::Value* value, llvm::Type* type )
+    {
+        if ( value->getType() == type )
+            return value;
+
+        if ( type == box_type )
+            return box( value );
+
+        if ( is_box( value ) )
+            return unbox( value, type );
+
+        if ( is_integer( value ) && type->isDoubleTy() )
+            return builder.CreateSIToFP( value, type );
+
+        if ( is_integer( value ) && type->isIntegerTy() )
+        {
+            llvm::Value* wide = builder.CreateSExt( value, type );
+            set_range( wide, get_range( value ) );
+
+            return wide;
+        }
+
+        return value;
+    }
+
+    llvm::Value* code_generation::is_truthy( llvm::Value* value )
+    {
+        if ( value->getType()->isIntegerTy( 1 ) )
+            return value;
+
+        if ( !is_box( value ) )
+            return builder.getTrue();
+
+        // Only nil and false are false, both have a single bit pattern
+        llvm::Value* bits = builder.CreateExtractValue( value, 0 );
+
+        return builder.CreateAnd(
+            builder.CreateICmpNE( bits, builder.getInt64( get_tag_bits( box_tag::nil ) ) ),
+            builder.CreateICmpNE( bits, builder.getInt64( get_tag_bits( box_tag::boolean ) ) ) );
+    }
+
+    llvm::Value* code_generation::is_equal( llvm::Value* left, llvm::Value* right )
+    {
+        llvm::Value* left_bits = builder.CreateExtractValue( left, 0 );
+        llvm::Value* right_bits = builder.CreateExtractValue( right, 0 );
+
+        // Numbers are compared as numbers (NaN is not equal to itself, zero is equal to negative zero), everything
+        // else by its bits. The bits of all other values are NaNs, which are not equal to any number.
+        llvm::Value* same_number = builder.CreateFCmpOEQ(
+            builder.CreateBitCast( left_bits, builder.getDoubleTy() ),
+            builder.CreateBitCast( right_bits, builder.getDoubleTy() ) );
+
+        llvm::Value* equal = builder.CreateSelect(
+            has_type( left_bits, builder.getDoubleTy() ), same_number, builder.CreateICmpEQ( left_bits, right_bits ) );
+
+        // Only strings at different addresses are compared by their characters
+        llvm::Value* strings = builder.CreateAnd(
+            builder.CreateAnd(
+                has_type( left_bits, builder.getInt8PtrTy() ), has_type( right_bits, builder.getInt8PtrTy() ) ),
+            builder.CreateNot( equal ) );
+
+        llvm::Function* function = builder.GetInsertBlock()->getParent();
+        auto* before = builder.GetInsertBlock();
+        auto* compare = llvm::BasicBlock::Create( context, "compare.strings", function );
+        auto* done = llvm::BasicBlock::Create( context, "compared", function );
+
+        builder.CreateCondBr( strings, compare, done );
+
+        builder.SetInsertPoint( compare );
+        const auto string = [ & ]( llvm::Value* bits )
+        {
+            return builder.CreateIntToPtr(
+                builder.CreateAnd( bits, builder.getInt64( payload_mask ) ), builder.getInt8PtrTy() );
+        };
+
+        llvm::Value* same_string =
+            builder.CreateICmpEQ( compare_strings( string( left_bits ), string( right_bits ) ), builder.getInt32( 0 ) );
+        auto* after = builder.GetInsertBlock();
+        builder.CreateBr( done );
+
+        builder.SetInsertPoint( done );
+        llvm::PHINode* result = builder.CreatePHI( builder.getInt1Ty(), 2 );
+        result->addIncoming( equal, before );
+        result->addIncoming( same_string, after );
+
+        return result;
+    }
+
+    bool code_generation::is_box( llvm::Value* value ) const
+    {
+        return value->getType() == box_type;
+    }
+
+    llvm::Constant* code_generation::get_nil() const
+    {
+        return llvm::ConstantStruct::get(
+            box_type, { llvm::ConstantInt::get( box_type->getElementType( 0 ), get_tag_bits( box_tag::nil ) ) } );
+    }
+
+    llvm::Constant* code_generation::create_integer( std::int64_t value )
+    {
+        return llvm::ConstantInt::get( get_integer_type( { value, value } ), value, true );
+    }
+
+    bool code_generation::is_integer( llvm::Value* value ) const
+    {
+        return value->getType()->isIntegerTy() && !value->getType()->isIntegerTy( 1 );
+    }
+
+    code_generation::integer_range code_generation::get_range( llvm::Value* value ) const
+    {
+        if ( const auto constant = llvm::dyn_cast< llvm::ConstantInt >( value ) )
+            return { constant->getSExtValue(), constant->getSExtValue() };
+
+        if ( const auto it = ranges.find( value ); it != ranges.end() )
+            return it->second;
+
+        if ( value->getType()->isIntegerTy( 32 ) )
+            return { std::numeric_limits< std::int32_t >::min(), std::numeric_limits< std::int32_t >::max() };
+
+        return { -max_integer + 1, max_integer - 1 };
+    }
+
+    void code_generation::set_range( llvm::Value* value, integer_range range )
+    {
+        if ( !llvm::isa< llvm::Constant >( value ) )
+            ranges[ value ] = range;
+    }
+
+    llvm::IntegerType* code_generation::get_integer_type( integer_range range )
+    {
+        if ( range.min >= std::numeric_limits< std::int32_t >::min() &&
+             range.max <= std::numeric_limits< std::int32_t >::max() )
+            return builder.getInt32Ty();
+
+        return builder.getInt64Ty();
+    }
+
+    box_tag code_generation::get_tag( llvm::Type* type ) const
+    {
+        if ( type->isIntegerTy( 1 ) )
+            return box_tag::boolean;
+
+        // Strings are pointers to characters, tables pointers to their properties
+        if ( type->isPointerTy() && type->getPointerElementType()->isIntegerTy( 8 ) )
+            return box_tag::string;
+
+        if ( type->isPointerTy() )
+            return box_tag::table;
+
+        throw utils::compiler_error( "values of this type cannot be boxed yet" );
+    }
+
+    std::uint64_t code_generation::get_tag_bits( box_tag tag )
+    {
+        return static_cast< std::uint64_t >( tag ) << 48;
+    }
+
+    void code_generation::check( llvm::Value* condition, const llvm::Twine& name )
+    {
+        llvm::Function* function = builder.GetInsertBlock()->getParent();
+
+        auto* trap = llvm::BasicBlock::Create( context, name + ".trap", function );
+        auto* valid = llvm::BasicBlock::Create( context, name + ".valid", function );
+
+        // The condition is expected to hold, which tells passes like IRCE that the check is worth removing
+        builder.CreateCondBr(
+            condition,
+            valid,
+            trap,
+            llvm::MDBuilder( context ).createBranchWeights( std::numeric_limits< std::uint32_t >::max() - 1, 1 ) );
+
+        builder.SetInsertPoint( trap );
+        builder.CreateIntrinsic( llvm::Intrinsic::trap, {}, {} );
+        builder.CreateUnreachable();
+
+        builder.SetInsertPoint( valid );
+    }
+
+    llvm::Value* code_generation::has_type( llvm::Value* bits, llvm::Type* type )
+    {
+        // Every bit pattern below the first tag is a number
+        if ( type->isDoubleTy() )
+            return builder.CreateICmpULT( bits, builder.getInt64( get_tag_bits( box_tag::nil ) ) );
+
+        return builder.CreateICmpEQ(
+            builder.CreateLShr( bits, 48 ), builder.getInt64( static_cast< std::uint64_t >( get_tag( type ) ) ) );
+    }
+
+    void code_generation::set_local( const std::string& name, llvm::Value* value )
+    {
+        if ( value )
+            locals[ name ] = value;
+        else
+            locals.erase( name );
+    }
+
+    llvm::Value* code_generation::load_field( llvm::Value* table, ast::type::type& type, std::size_t property )
+    {
+        const auto& descriptor = std::get< ast::type::descriptor::table >( type.value );
+
+        // The shape comes before the properties
+        const auto field = static_cast< unsigned >( descriptor.get_layout().field_of[ property ] + 1 );
+
+        auto* struct_type = llvm::cast< llvm::StructType >( table->getType()->getPointerElementType() );
+
+        return builder.CreateLoad(
+            struct_type->getElementType( field ),
+            builder.CreateStructGEP( struct_type, table, field ),
+            descriptor.properties[ property ].name );
+    }
+
+    llvm::Value* code_generation::is_present( llvm::Value* table, ast::type::type& type, std::size_t property )
+    {
+        const auto bit = std::get< ast::type::descriptor::table >( type.value ).get_layout().bit_of[ property ];
+
+        if ( !bit )
+            return nullptr;
+
+        llvm::Value* byte = builder.CreateLoad( builder.getInt8Ty(), get_mask( table, *bit / 8 ) );
+
+        return builder.CreateICmpNE(
+            builder.CreateAnd( byte, builder.getInt8( 1 << ( *bit % 8 ) ) ), builder.getInt8( 0 ) );
+    }
+
+    llvm::Value* code_generation::get_mask( llvm::Value* table, std::size_t byte )
+    {
+        auto* struct_type = llvm::cast< llvm::StructType >( table->getType()->getPointerElementType() );
+
+        // The mask comes after the properties
+        return builder.CreateInBoundsGEP(
+            struct_type,
+            table,
+            { builder.getInt32( 0 ),
+              builder.getInt32( struct_type->getNumElements() - 1 ),
+              builder.getInt32( static_cast< std::uint32_t >( byte ) ) } );
+    }
+
+    llvm::Value* code_generation::get_local( const std::string& name ) const
+    {
+        const auto it = locals.find( name );
+
+        return it != locals.end() ? it->second : nullptr;
+    }
+
+    llvm::Value* code_generation::allocate( llvm::Type* type, std::uint64_t count )
+    {
+        auto* size_type = llvm::Type::getInt64Ty( context );
+
+        const auto malloc = llvm_module->getOrInsertFunction(
+            "malloc", llvm::FunctionType::get( llvm::Type::getInt8PtrTy( context ), { size_type }, false ) );
+
+        // The size is a constant expression, the data layout is only known once the target is
+        llvm::Constant* size = llvm::ConstantExpr::getMul(
+            llvm::ConstantExpr::getSizeOf( type ), llvm::ConstantInt::get( size_type, count ) );
+
+        return builder.CreateBitCast( builder.CreateCall( malloc, { size } ), type->getPointerTo() );
+    }
+
     llvm::Function* code_generation::compile_external_decleration( std::shared_ptr< ast::variable > variable )
     {
         return get_or_create_function( variable, true );
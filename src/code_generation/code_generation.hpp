@@ -1,34 +1,70 @@
 #pragma once
 
+#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
-#include <llvm/Support/TargetSelect.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 
 #include "../ast/statement.hpp"
 
 namespace lorraine::code_generation
 {
+    /// @brief Type of a boxed value, the 16 bits at the top of the box (see code_generation::box). Numbers have no
+    /// tag, every box below the first tag is a number.
+    enum class box_tag : std::uint16_t
+    {
+        nil = 0xfff9,
+        boolean,
+        string,
+        table,
+    };
+
+    /// @brief How a property is stored in a table, so that it can be boxed when it is read through a value of any
+    /// type (see code_generation::get_dynamic_property)
+    enum class field_kind : std::uint8_t
+    {
+        number,
+        boolean,
+        string,
+        table,
+        any,
+    };
+
     class code_generation
     {
        public:
         /// @brief Creates a new instance of the LLVM code generator
         /// @param ast_module
-        code_generation( ast::module* ast_module )
-            : llvm_module( std::make_unique< llvm::Module >( ast_module->info->name, context ) ),
-              ast_module( ast_module )
+        /// @param context LLVM context that will own the generated module. It must outlive the module.
+        code_generation( ast::module* ast_module, llvm::LLVMContext& context )
+            : context( context ),
+              llvm_module( std::make_unique< llvm::Module >( ast_module->info->name, context ) ),
+              ast_module( ast_module ),
+              builder( context ),
+              box_type( llvm::cast< llvm::StructType >(
+                  ast::type::type( ast::type::type::primitive_type::any ).to_llvm_type( context ) ) )
         {
-            llvm::InitializeAllTargetInfos();
-            llvm::InitializeAllTargets();
-            llvm::InitializeAllTargetMCs();
-            llvm::InitializeAllAsmParsers();
-            llvm::InitializeAllAsmPrinters();
-
             llvm_module->setSourceFileName( ast_module->info->absolute() );
+            create_shape_types();
         }
 
-        /// @brief Generates an LLVM module from the AST module
+        /// @brief Generates an LLVM module from the AST module. Ownership of the module is handed to the caller, so
+        /// this can only be called once.
+        /// @return New LLVM module
+        std::unique_ptr< llvm::Module > generate();
+
+        /// @brief Appends a top-level statement of the AST module to the entry function. Used to generate a module
+        /// one statement at a time, the statement can be destroyed afterwards.
+        /// @param statement The statement
+        void generate( ast::statement* statement );
+
+        /// @brief Completes the entry function after the last statement. Ownership of the module is handed to the
+        /// caller, so this can only be called once.
         /// @return New LLVM module
-        std::shared_ptr< llvm::Module > generate();
+        std::unique_ptr< llvm::Module > finish();
 
         /// @brief Gets or creates a function from a variable
         /// @param variable Variable
@@ -36,12 +72,316 @@ namespace lorraine::code_generation
         /// @return New or existing function
         llvm::Function* get_or_create_function( std::shared_ptr< ast::variable > variable, bool external = false );
 
+        /// @brief Gets or creates a pointer to a constant, null terminated string. Every string only exists once in
+        /// the module, however often it is used.
+        /// @param value The string
+        /// @return Pointer to its first character
+        llvm::Constant* get_string( const std::string& value );
+
+        /// @brief Compares two strings by their characters, like strcmp does
+        /// @return Less than, equal to or greater than zero (i32) if the first string is ordered before, is equal to or
+        /// is ordered after the second one
+        llvm::Value* compare_strings( llvm::Value* left, llvm::Value* right );
+
+        /// @brief Concatenates two strings only known at run time into a new string. Strings are never freed, like
+        /// the ones arrays are converted to.
+        /// @return Pointer to the first character of the new string
+        llvm::Value* concat( llvm::Value* left, llvm::Value* right );
+
+        /// @brief Creates an array (see ast::type::type::to_llvm_type). If all elements are constants, the array is a
+        /// constant that refers to read-only data, so it costs nothing at run time. Otherwise its elements are
+        /// allocated and stored.
+        /// @param type Type of the array
+        /// @param elements Values of the elements
+        /// @return The array
+        llvm::Value* create_array( llvm::StructType* type, const std::vector< llvm::Value* >& elements );
+
+        /// @brief Creates a table (see ast::type::type::to_llvm_type). If all properties are constants, the table
+        /// points to read-only data, so it costs nothing at run time. Otherwise it is allocated and its properties
+        /// are stored.
+        /// @param type Type of the table
+        /// @param properties Values of the properties by name, optional properties that are absent are left out
+        /// @return Pointer to the table
+        llvm::Value* create_table(
+            ast::type::type& type, const std::unordered_map< std::string, llvm::Value* >& properties );
+
+        /// @brief Reads a property of a table through a value of any type. Every table points to its shape: the
+        /// names, offsets and kinds of its properties. The access has an inline cache of the last shapes it saw and
+        /// where the property is in them, so a hit is a compare of the shape and a load at a known offset. The shape
+        /// is only searched on a miss. The program traps if the value is not a table.
+        /// @param value The value
+        /// @param name Name of the property
+        /// @return The property (boxed), nil if the table has no such property
+        llvm::Value* get_dynamic_property( llvm::Value* value, const std::string& name );
+
+        /// @brief Reads a property of a table through a value of any type, by a name only known at run time. The
+        /// shape is searched every time.
+        /// @param value The value
+        /// @param name Name of the property, a string
+        /// @return The property (boxed), nil if the table has no such property
+        llvm::Value* get_dynamic_property( llvm::Value* value, llvm::Value* name );
+
+        /// @brief Makes a value of an interface type from a value that implements it. It points to a copy of the
+        /// value and to the itable of the implementation: a constant with a function for every member of the
+        /// interface, in the order the interface declares them.
+        /// @param value The value
+        /// @param type Type of the value
+        /// @param interface The interface type
+        /// @return The value of the interface type (see ast::type::type::to_llvm_type)
+        llvm::Value* create_interface( llvm::Value* value, ast::type::type& type, ast::type::type& interface );
+
+        /// @brief Calls a method of a value, or reads a property of a value of an interface type. If the type that
+        /// implements the member is known (the value is not of an interface type, or its itable is a constant) the
+        /// implementation is called directly, so it can be inlined. Otherwise it is loaded from its slot in the
+        /// itable.
+        /// @param receiver The value
+        /// @param type Type of the value
+        /// @param name Name of the member
+        /// @param arguments Arguments of the method
+        /// @return The value the member returns
+        llvm::Value* call_member(
+            llvm::Value* receiver,
+            ast::type::type& type,
+            const std::string& name,
+            const std::vector< llvm::Value* >& arguments = {} );
+
+        /// @brief Gets the number of elements of an array, a number that is lowered to an integer
+        /// @param array The array
+        /// @return The length
+        llvm::Value* get_length( llvm::Value* array );
+
+        /// @brief Loads an element of an array. The program traps if the index is not an integer in the bounds of
+        /// the array.
+        /// @param array The array
+        /// @param index Index of the element, a number or a box holding one. The first element is at 1.
+        /// @return The element
+        llvm::Value* get_element( llvm::Value* array, llvm::Value* index );
+
+        /// @brief Loads a property of a table from its field. An optional property is boxed, it is nil if it is absent.
+        /// @param table Pointer to the table
+        /// @param type Type of the table
+        /// @param name Name of the property
+        /// @return The value
+        llvm::Value* get_property( llvm::Value* table, ast::type::type& type, const std::string& name );
+
+        /// @brief Converts a table to another table type it is assignable to. The properties are at other offsets in
+        /// another type (see descriptor::table::get_layout), so a table of the other type is created and the
+        /// properties are copied to it, tables in them are converted as well. The program traps if a property that
+        /// is optional in the table but required in the other type is absent.
+        /// @param table Pointer to the table
+        /// @param from Type of the table
+        /// @param to The other table type
+        /// @return Pointer to the table of the other type, the table itself if the types are the same
+        llvm::Value* convert_table( llvm::Value* table, ast::type::type& from, ast::type::type& to );
+
+        /// @brief Calls a variadic function like printf. C does not know boxes, so a boxed variadic argument is
+        /// passed as the value in it. If the last fixed argument is a constant format string, its conversion decides:
+        /// a double for the floating point ones (NaN if the box holds no number), a 64 bit integer otherwise (the
+        /// number truncated, or the pointer of a string or table, 0 or 1 for a boolean and 0 for nil). The other
+        /// boxed arguments are passed as a double if they hold a number and the 64 bits of their value otherwise,
+        /// which is only known at run time (see fork_variadic).
+        /// @param function The function
+        /// @param arguments The arguments, the ones before the variadic ones already converted to their parameters
+        /// @return The value the function returns
+        llvm::Value* call_variadic( llvm::Function* function, std::vector< llvm::Value* > arguments );
+
+        /// @brief Boxes a value, so that it can be used where a value of any type is expected. Values are only boxed
+        /// there, everywhere else they keep their own type. Locals are never assigned again, so even the value of a
+        /// local without a type annotation is only boxed once it is used as a value of any type.
+        ///
+        /// A box is 64 bits, passed in a single register. Numbers are their own bits (all NaNs are made one quiet
+        /// NaN), every other value is a NaN that no number has: its tag in the 16 bits at the top and the value in
+        /// the 48 bits below them, a boolean as 0 or 1 and strings and tables as their pointer.
+        /// @param value The value: a number, boolean, string, table or an already boxed value
+        /// @return The box, a constant if the value is one
+        llvm::Value* box( llvm::Value* value );
+
+        /// @brief Takes a value out of a box, checking that it has the expected type. The program traps otherwise.
+        /// @param value The box
+        /// @param type Type of the value in the box (number, boolean, string or table)
+        /// @return The value
+        llvm::Value* unbox( llvm::Value* value, llvm::Type* type );
+
+        /// @brief Converts a value to the type a parameter, element or property expects, boxing or unboxing it.
+        /// Numbers that are lowered to integers are made doubles (or wider integers).
+        /// @param value The value
+        /// @param type The expected type
+        /// @return The converted value
+        llvm::Value* convert( llvm::Value* value, llvm::Type* type );
+
+        /// @brief Checks if a value counts as true in a condition: everything except nil and false does
+        /// @param value The value
+        /// @return The condition (i1)
+        llvm::Value* is_truthy( llvm::Value* value );
+
+        /// @brief Compares two boxes like '==' does: values of different types are not equal, strings are equal if
+        /// their characters are
+        /// @return The condition (i1)
+        llvm::Value* is_equal( llvm::Value* left, llvm::Value* right );
+
+        /// @brief Checks if a value is a box (see box)
+        bool is_box( llvm::Value* value ) const;
+
+        /// @brief The value of nil, which only exists boxed
+        llvm::Constant* get_nil() const;
+
+        /// @brief Range of the values of an integer number
+        struct integer_range
+        {
+            std::int64_t min = 0, max = 0;
+        };
+
+        /// @brief Numbers are only lowered to integers below this magnitude. Every integer there is exact as a double,
+        /// so an integer converted back to a double has the value the double arithmetic would have had.
+        static constexpr std::int64_t max_integer = std::int64_t( 1 ) << 53;
+
+        /// @brief Creates a number that is an integer, an i32 if it fits and an i64 otherwise
+        /// @param value The value, below max_integer
+        llvm::Constant* create_integer( std::int64_t value );
+
+        /// @brief Checks if a value is a number that is lowered to an integer (booleans are not)
+        bool is_integer( llvm::Value* value ) const;
+
+        /// @brief Gets the range of the values of a number that is lowered to an integer
+        integer_range get_range( llvm::Value* value ) const;
+
+        /// @brief Sets the range of the values of a number that is lowered to an integer, unless it is a constant
+        void set_range( llvm::Value* value, integer_range range );
+
+        /// @brief Gets the type numbers in a range are lowered to: i32 if it fits, i64 otherwise
+        llvm::IntegerType* get_integer_type( integer_range range );
+
+        /// @brief Sets the value of a local variable. Locals are never assigned again, so they are SSA values.
+        /// @param name Name of the variable
+        /// @param value Its value, nullptr if it has none
+        void set_local( const std::string& name, llvm::Value* value );
+
+        /// @brief Gets the value of a local variable
+        /// @param name Name of the variable
+        /// @return Its value, nullptr if it has none
+        llvm::Value* get_local( const std::string& name ) const;
+
        private:
-        llvm::LLVMContext context;
+        llvm::LLVMContext& context;
 
-        std::shared_ptr< llvm::Module > llvm_module;
+        std::unique_ptr< llvm::Module > llvm_module;
         ast::module* ast_module;
 
+        /// @brief Builder positioned at the end of the entry function
+        llvm::IRBuilder<> builder;
+        llvm::Function* entry_function = nullptr;
+
+        std::unordered_map< std::string, llvm::Constant* > strings;
+        std::unordered_map< std::string, llvm::Value* > locals;
+
+        /// @brief Ranges of the integers computed at run time (see get_range)
+        std::unordered_map< llvm::Value*, integer_range > ranges;
+
+        /// @brief Type of boxed values (see box)
+        llvm::StructType* box_type;
+
+        /// @brief Types of shapes, their entries and the entries of inline caches (see get_shape)
+        llvm::StructType* shape_type;
+        llvm::StructType* shape_entry_type;
+        llvm::StructType* cache_entry_type;
+
+        /// @brief The bits of the NaN all NaNs are boxed as
+        static constexpr std::uint64_t canonical_nan = 0x7ff8000000000000;
+
+        /// @brief Mask of the value in a box with a tag
+        static constexpr std::uint64_t payload_mask = 0x0000ffffffffffff;
+
+        /// @brief Calls a variadic function with the boxed arguments no format string decides, branching on the type
+        /// of each of them. It is a call for every combination of their types (see call_variadic).
+        llvm::Value* fork_variadic( llvm::Function* function, std::vector< llvm::Value* > arguments );
+
+        /// @brief Gets the tag of values of a type, other than numbers
+        box_tag get_tag( llvm::Type* type ) const;
+
+        /// @brief Gets the bits of a box with a tag and a value of zero
+        static std::uint64_t get_tag_bits( box_tag tag );
+
+        /// @brief Number of shapes the inline cache of a property access remembers
+        static constexpr std::size_t cache_size = 4;
+
+        /// @brief Shapes by the table type they describe
+        std::unordered_map< std::string, llvm::Constant* > shapes;
+
+        /// @brief Number of slots in a group of the index of a shape, their control bytes are compared at once
+        static constexpr std::size_t group_size = 8;
+
+        /// @brief Gets the shape of a table type, the constant every table of the type points to. It has the
+        /// properties that can be boxed and an index of them by name:
+        /// `{ i64 count, %shape.entry* entries, i64 group_mask, i64* control, i32* slots }`. Every entry is
+        /// `{ i8* name, i64 hash, i64 offset, i64 kind, i64 mask_offset, i64 bit }` (bit is -1 for properties that
+        /// are not optional). The index is an open addressing hash table like SwissTable: a word of control bytes
+        /// for every group of slots, and the entry in every slot.
+        llvm::Constant* get_shape( ast::type::type& type );
+
+        /// @brief Gets the function that searches the index of a shape for a property (by its name and hash). On a
+        /// miss of an inline cache, it puts the shape and the entry it found (null if there is none) at the front of
+        /// the cache.
+        llvm::Function* get_lookup_function();
+
+        /// @brief Gets the function that hashes a name only known at run time, like the names of properties are
+        llvm::Function* get_hash_function();
+
+        /// @brief Gets the function that reads and boxes the property of a table an entry of its shape describes
+        llvm::Function* get_load_function();
+
+        /// @brief Checks that a value is a table and gets the pointer to it
+        llvm::Value* get_object( llvm::Value* value );
+
+        /// @brief Itables by the type that implements an interface and the interface
+        std::unordered_map< std::string, llvm::Constant* > itables;
+
+        /// @brief Gets the itable of a type for an interface (see create_interface)
+        llvm::Constant* get_itable( ast::type::type& type, ast::type::descriptor::interface& interface );
+
+        /// @brief Gets the function that implements a member of the Array interface for an array type. Members take
+        /// a pointer to the value as their first argument, properties are read by calling them.
+        /// @param type The array type
+        /// @param name Name of the member
+        llvm::Function* get_member( ast::type::type& type, const std::string& name );
+
+        /// @brief Creates the function that converts the elements of an array to a string, like `{1, 2, 3}`. Only
+        /// numbers, strings and booleans can be converted yet, the function traps for other elements.
+        void create_to_string( llvm::Function* function, ast::type::type& element );
+
+        /// @brief Makes the program trap unless a condition holds
+        /// @param condition The condition (i1)
+        /// @param name Prefix of the names of the blocks
+        void check( llvm::Value* condition, const llvm::Twine& name );
+
+        /// @brief Checks if the bits of a box are a value of a type
+        /// @return The condition (i1)
+        llvm::Value* has_type( llvm::Value* bits, llvm::Type* type );
+
+        /// @brief Creates the types of shapes (or gets them if the context has them already)
+        void create_shape_types();
+
+        /// @brief Creates the entry function ('main') of the module if it does not exist yet
+        void create_entry_function();
+
+        /// @brief Allocates memory for values of a type on the heap
+        /// @param type The type
+        /// @param count Number of values
+        /// @return Pointer to the first value
+        llvm::Value* allocate( llvm::Type* type, std::uint64_t count );
+
+        /// @brief Loads the field of a property of a table as it is stored, optional properties are not boxed
+        /// @param table Pointer to the table
+        /// @param type Type of the table
+        /// @param property Index of the property
+        llvm::Value* load_field( llvm::Value* table, ast::type::type& type, std::size_t property );
+
+        /// @brief Checks if a property of a table is present
+        /// @return The condition (i1), nullptr if the property is not optional
+        llvm::Value* is_present( llvm::Value* table, ast::type::type& type, std::size_t property );
+
+        /// @brief Gets a pointer to a byte of the mask of the optional properties of a table
+        llvm::Value* get_mask( llvm::Value* table, std::size_t byte );
+
         llvm::Function* compile_external_decleration( std::shared_ptr< ast::variable > variable );
     };
 }  // namespace lorraine::code_generation
@@ -1,9 +1,26 @@
 #include "llvm_visitor.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
 #include "../utils/error.hpp"
 
 namespace lorraine::code_generation
 {
+    namespace
+    {
+        /// @brief Checks if a property is a method of an array or of a value of an interface type
+        bool is_member( ast::name_index* node )
+        {
+            const auto& receiver = node->variable->type->value;
+
+            return std::holds_alternative< ast::type::descriptor::function >( node->type->value ) &&
+                   ( std::holds_alternative< ast::type::descriptor::array >( receiver ) ||
+                     std::holds_alternative< ast::type::descriptor::interface >( receiver ) );
+        }
+    }  // namespace
+
     bool llvm_collector::visit( ast::external_decleration* item )
     {
         external_declerations.push_back( item->var );
@@ -12,13 +29,19 @@ namespace lorraine::code_generation
 
     bool llvm_visitor::visit( ast::number_literal* node )
     {
-        value = llvm::ConstantFP::get( builder.getContext(), llvm::APFloat( node->value ) );
+        // Integers are lowered to integer arithmetic for as long as their values provably stay integers (see
+        // generate_integer). Zero is an integer, negative zero is not.
+        if ( node->integer && std::abs( node->value ) < code_generation::max_integer && !std::signbit( node->value ) )
+            value = gen.create_integer( static_cast< std::int64_t >( node->value ) );
+        else
+            value = llvm::ConstantFP::get( builder.getContext(), llvm::APFloat( node->value ) );
+
         return false;
     }
 
     bool llvm_visitor::visit( ast::string_literal* node )
     {
-        value = builder.CreateGlobalStringPtr( llvm::StringRef( node->value.c_str() ) );
+        value = gen.get_string( node->value );
         return false;
     }
 
@@ -28,8 +51,28 @@ namespace lorraine::code_generation
         return false;
     }
 
+    bool llvm_visitor::visit( ast::nil_literal* node )
+    {
+        value = gen.get_nil();
+        return false;
+    }
+
     bool llvm_visitor::visit( ast::call* node )
     {
+        // Methods of arrays and of values of interface types (see code_generation::call_member)
+        if ( const auto method = dynamic_cast< ast::name_index* >( node->function.get() );
+             method && is_member( method ) )
+        {
+            llvm::Value* receiver = generate( method->variable.get() );
+            std::vector< llvm::Value* > args;
+
+            for ( const auto& arg : node->arguments )
+                args.push_back( generate( arg.get() ) );
+
+            value = gen.call_member( receiver, *method->variable->type, method->name, args );
+            return false;
+        }
+
         node->function->visit( this );
         
         if (const auto func = llvm::dyn_cast< llvm::Function >( value ))
@@ -38,9 +81,20 @@ namespace lorraine::code_generation
             for ( const auto& arg : node->arguments )
             {
                 arg->visit( this );
+
+                // Variadic arguments are passed as they are, like in C. Only integers are numbers (doubles) again,
+                // booleans are promoted to int like C does and boxes are opened at run time (see
+                // code_generation::call_variadic).
+                if ( args.size() < func->getFunctionType()->getNumParams() )
+                    value = gen.convert( value, func->getFunctionType()->getParamType( args.size() ) );
+                else if ( gen.is_integer( value ) )
+                    value = gen.convert( value, builder.getDoubleTy() );
+                else if ( value->getType()->isIntegerTy( 1 ) )
+                    value = builder.CreateZExt( value, builder.getInt32Ty() );
+
                 args.push_back( value );
             }
-            value = builder.CreateCall( func, args );
+            value = func->isVarArg() ? gen.call_variadic( func, args ) : builder.CreateCall( func, args );
         }
         else
             throw utils::compiler_error( "Invalid function type" );
@@ -53,10 +107,471 @@ namespace lorraine::code_generation
         {
             value = gen.get_or_create_function( node->var );
         }
+        else if ( !( value = gen.get_local( node->var->value ) ) )
+            throw utils::compiler_error( "variable '" + node->var->value + "' has no value" );
+
+        return false;
+    }
+
+    bool llvm_visitor::visit( ast::name_index* node )
+    {
+        if ( is_member( node ) )
+            throw utils::compiler_error( "the method '" + node->name + "' can only be called" );
+
+        llvm::Value* variable = generate( node->variable.get() );
+
+        // The length of an array is the one property of the Array interface that has a value
+        if ( std::holds_alternative< ast::type::descriptor::array >( node->variable->type->value ) )
+            value = gen.get_length( variable );
+        else if ( std::holds_alternative< ast::type::descriptor::interface >( node->variable->type->value ) )
+            value = gen.call_member( variable, *node->variable->type, node->name );
+        else if ( std::holds_alternative< ast::type::descriptor::table >( node->variable->type->value ) )
+            value = gen.get_property( variable, *node->variable->type, node->name );
+        else
+            value = gen.get_dynamic_property( variable, node->name );
+
+        return false;
+    }
+
+    bool llvm_visitor::visit( ast::expression_index* node )
+    {
+        llvm::Value* variable = generate( node->variable.get() );
+        llvm::Value* index = generate( node->index.get() );
+
+        if ( std::holds_alternative< ast::type::descriptor::array >( node->variable->type->value ) )
+            value = gen.get_element( variable, index );
         else
+            value = gen.get_dynamic_property( variable, index );
+
+        return false;
+    }
+
+    bool llvm_visitor::visit( ast::expression_group* node )
+    {
+        value = generate( node->value.get() );
+        return false;
+    }
+
+    // Operations on literals were folded before (see ast::folder), these have at least one operand that is only known
+    // at run time
+    bool llvm_visitor::visit( ast::binary_expression* node )
+    {
+        if ( node->op == ast::binary_operator::logical_and || node->op == ast::binary_operator::logical_or )
         {
-            // TODO: Implement
+            value = generate_logical( node );
+            return false;
         }
+
+        llvm::Value* left = generate( node->left.get() );
+        llvm::Value* right = generate( node->right.get() );
+
+        const bool equality = node->op == ast::binary_operator::equal || node->op == ast::binary_operator::not_equal;
+
+        // Values of any type are compared in their box (as values of different types are not equal), they are only
+        // taken out of it for the other operators
+        if ( equality && ( gen.is_box( left ) || gen.is_box( right ) ) )
+        {
+            value = gen.is_equal( gen.box( left ), gen.box( right ) );
+
+            if ( node->op == ast::binary_operator::not_equal )
+                value = builder.CreateNot( value );
+
+            return false;
+        }
+
+        if ( gen.is_box( left ) )
+            left = gen.unbox(
+                left, gen.is_box( right ) || gen.is_integer( right ) ? builder.getDoubleTy() : right->getType() );
+
+        if ( gen.is_box( right ) )
+            right = gen.unbox( right, gen.is_integer( left ) ? builder.getDoubleTy() : left->getType() );
+
+        if ( gen.is_integer( left ) && gen.is_integer( right ) &&
+             ( value = generate_integer( node->op, left, right ) ) )
+            return false;
+
+        // Otherwise integers are converted back to doubles
+        if ( gen.is_integer( left ) )
+            left = gen.convert( left, builder.getDoubleTy() );
+
+        if ( gen.is_integer( right ) )
+            right = gen.convert( right, builder.getDoubleTy() );
+
+        if ( left->getType()->isDoubleTy() && right->getType()->isDoubleTy() )
+        {
+            switch ( node->op )
+            {
+                case ast::binary_operator::add: value = builder.CreateFAdd( left, right ); return false;
+                case ast::binary_operator::subtract: value = builder.CreateFSub( left, right ); return false;
+                case ast::binary_operator::multiply: value = builder.CreateFMul( left, right ); return false;
+                case ast::binary_operator::divide: value = builder.CreateFDiv( left, right ); return false;
+                case ast::binary_operator::modulo:
+                {
+                    // Like in Lua, the result has the sign of the divisor
+                    llvm::Value* remainder = builder.CreateFRem( left, right );
+                    llvm::Value* zero = llvm::ConstantFP::get( left->getType(), 0.0 );
+
+                    llvm::Value* adjust = builder.CreateAnd(
+                        builder.CreateFCmpUNE( remainder, zero ),
+                        builder.CreateXor(
+                            builder.CreateFCmpOLT( remainder, zero ), builder.CreateFCmpOLT( right, zero ) ) );
+
+                    value = builder.CreateSelect( adjust, builder.CreateFAdd( remainder, right ), remainder );
+                    return false;
+                }
+                case ast::binary_operator::power:
+                    value = builder.CreateBinaryIntrinsic( llvm::Intrinsic::pow, left, right );
+                    return false;
+                case ast::binary_operator::equal: value = builder.CreateFCmpOEQ( left, right ); return false;
+                case ast::binary_operator::not_equal: value = builder.CreateFCmpUNE( left, right ); return false;
+                case ast::binary_operator::less: value = builder.CreateFCmpOLT( left, right ); return false;
+                case ast::binary_operator::less_equal: value = builder.CreateFCmpOLE( left, right ); return false;
+                case ast::binary_operator::greater: value = builder.CreateFCmpOGT( left, right ); return false;
+                case ast::binary_operator::greater_equal: value = builder.CreateFCmpOGE( left, right ); return false;
+                default: break;
+            }
+        }
+        else if ( left->getType() == builder.getInt8PtrTy() && right->getType() == builder.getInt8PtrTy() )
+        {
+            if ( node->op == ast::binary_operator::concat )
+            {
+                value = gen.concat( left, right );
+                return false;
+            }
+
+            llvm::Value* order = gen.compare_strings( left, right );
+            llvm::Value* zero = builder.getInt32( 0 );
+
+            switch ( node->op )
+            {
+                case ast::binary_operator::equal: value = builder.CreateICmpEQ( order, zero ); return false;
+                case ast::binary_operator::not_equal: value = builder.CreateICmpNE( order, zero ); return false;
+                case ast::binary_operator::less: value = builder.CreateICmpSLT( order, zero ); return false;
+                case ast::binary_operator::less_equal: value = builder.CreateICmpSLE( order, zero ); return false;
+                case ast::binary_operator::greater: value = builder.CreateICmpSGT( order, zero ); return false;
+                case ast::binary_operator::greater_equal: value = builder.CreateICmpSGE( order, zero ); return false;
+                default: break;
+            }
+        }
+        else if ( left->getType()->isIntegerTy( 1 ) && right->getType()->isIntegerTy( 1 ) )
+        {
+            switch ( node->op )
+            {
+                case ast::binary_operator::equal: value = builder.CreateICmpEQ( left, right ); return false;
+                case ast::binary_operator::not_equal: value = builder.CreateICmpNE( left, right ); return false;
+                default: break;
+            }
+        }
+
+        throw utils::compiler_error(
+            "operator '" + ast::binary_expression::to_string( node->op ) + "' is not supported on these operands" );
+    }
+
+    bool llvm_visitor::visit( ast::unary_expression* node )
+    {
+        llvm::Value* operand = generate( node->value.get() );
+
+        if ( node->op == ast::unary_operator::negate && gen.is_box( operand ) )
+            operand = gen.unbox( operand, builder.getDoubleTy() );
+
+        if ( node->op == ast::unary_operator::negate && operand->getType()->isDoubleTy() )
+            value = builder.CreateFNeg( operand );
+        else if ( node->op == ast::unary_operator::negate && gen.is_integer( operand ) )
+        {
+            // The negation of zero is negative zero, which integers do not have. It stays an integer only when its
+            // range excludes zero, the range is symmetric so it stays in it.
+            const auto range = gen.get_range( operand );
+
+            if ( range.min > 0 || range.max < 0 )
+            {
+                value = builder.CreateNSWNeg( operand );
+                gen.set_range( value, { -range.max, -range.min } );
+            }
+            else
+                value = builder.CreateFNeg( gen.convert( operand, builder.getDoubleTy() ) );
+        }
+        else if ( node->op == ast::unary_operator::logical_not )
+            value = builder.CreateNot( gen.is_truthy( operand ) );
+        else if ( node->op == ast::unary_operator::length && operand->getType()->isStructTy() )
+            value = gen.get_length( operand );
+        else
+            throw utils::compiler_error(
+                "operator '" + ast::unary_expression::to_string( node->op ) + "' is not supported on this operand" );
+
         return false;
     }
-}  // namespace lorraine::code_generation
\ No newline at end of file
+
+    bool llvm_visitor::visit( ast::list_constructor* node )
+    {
+        std::vector< llvm::Value* > elements;
+        std::unordered_map< std::string, llvm::Value* > properties;
+
+        for ( const auto& element : node->expressions )
+        {
+            // Not part of the visitor, only the values of table constructors are generated
+            if ( const auto assignment = dynamic_cast< ast::variable_assignment* >( element.get() ) )
+                properties[ assignment->var->value ] = generate( assignment->value.get() );
+            else
+                elements.push_back( generate( element.get() ) );
+        }
+
+        if ( std::holds_alternative< ast::type::descriptor::table >( node->type->value ) )
+            value = gen.create_table( *node->type, properties );
+        else
+            value = gen.create_array(
+                llvm::cast< llvm::StructType >( node->type->to_llvm_type( builder.getContext() ) ), elements );
+
+        return false;
+    }
+
+    bool llvm_visitor::visit( ast::local_assignment* node )
+    {
+        // The values are evaluated before the names refer to the new variables
+        std::vector< llvm::Value* > values;
+
+        for ( const auto& expression : node->values )
+            values.push_back( generate( expression.get() ) );
+
+        for ( std::size_t i = 0; i < node->variables.size(); ++i )
+        {
+            llvm::Value* value = i < values.size() ? values[ i ] : nullptr;
+            const auto& type = node->variables[ i ]->type;
+
+            // Tables are converted to the layout of the type of the variable
+            if ( value && type && std::holds_alternative< ast::type::descriptor::table >( type->value ) &&
+                 std::holds_alternative< ast::type::descriptor::table >( node->values[ i ]->type->value ) )
+                value = gen.convert_table( value, *node->values[ i ]->type, *type );
+
+            // Values that implement an interface are converted to it (see code_generation::create_interface)
+            if ( value && type && std::holds_alternative< ast::type::descriptor::interface >( type->value ) &&
+                 !std::holds_alternative< ast::type::descriptor::interface >( node->values[ i ]->type->value ) )
+                value = gen.create_interface( value, *node->values[ i ]->type, *type );
+
+            // A value of type any (e.g. a property looked up at run time) is unboxed into a variable of a primitive
+            // type
+            if ( value && gen.is_box( value ) && type &&
+                 ( type->is( ast::type::type::primitive_type::number ) ||
+                   type->is( ast::type::type::primitive_type::string ) ||
+                   type->is( ast::type::type::primitive_type::boolean ) ) )
+                value = gen.convert( value, type->to_llvm_type( builder.getContext() ) );
+
+            gen.set_local( node->variables[ i ]->value, value );
+        }
+
+        return false;
+    }
+
+    llvm::Value* llvm_visitor::generate( ast::expression* node )
+    {
+        value = nullptr;
+        node->visit( this );
+
+        if ( !value )
+            throw utils::compiler_error( "unable to generate a value for the expression" );
+
+        return value;
+    }
+
+    llvm::Value* llvm_visitor::generate_integer( ast::binary_operator op, llvm::Value* left, llvm::Value* right )
+    {
+        const auto a = gen.get_range( left );
+        const auto b = gen.get_range( right );
+
+        // The bounds of a result are computed as doubles. These are rounded, but a rounded bound is only below
+        // max_integer if the exact one is, and then it is exact.
+        const auto make_range =
+            []( std::initializer_list< double > bounds ) -> std::optional< code_generation::integer_range >
+        {
+            for ( const double bound : bounds )
+            {
+                if ( !( std::abs( bound ) < code_generation::max_integer ) )
+                    return std::nullopt;
+            }
+
+            const auto [ min, max ] = std::minmax( bounds );
+            return code_generation::integer_range{
+                static_cast< std::int64_t >( min ), static_cast< std::int64_t >( max ) };
+        };
+
+        const auto d = []( std::int64_t v ) { return static_cast< double >( v ); };
+
+        std::optional< code_generation::integer_range > range;
+
+        switch ( op )
+        {
+            case ast::binary_operator::add:
+                range = make_range( { d( a.min ) + d( b.min ), d( a.max ) + d( b.max ) } );
+                break;
+            case ast::binary_operator::subtract:
+                range = make_range( { d( a.min ) - d( b.max ), d( a.max ) - d( b.min ) } );
+                break;
+            case ast::binary_operator::multiply:
+            {
+                // Zero times a negative number is negative zero, which integers do not have
+                const auto has_zero = []( const code_generation::integer_range& r )
+                { return r.min <= 0 && r.max >= 0; };
+
+                if ( ( has_zero( a ) && b.min < 0 ) || ( has_zero( b ) && a.min < 0 ) )
+                    return nullptr;
+
+                range = make_range( {
+                    d( a.min ) * d( b.min ),
+                    d( a.min ) * d( b.max ),
+                    d( a.max ) * d( b.min ),
+                    d( a.max ) * d( b.max ),
+                } );
+                break;
+            }
+            case ast::binary_operator::modulo:
+            {
+                // Like in Lua, the result has the sign of the divisor. It can only be lowered if the divisor is never
+                // zero, the modulo of doubles is NaN then, and if the dividend is never negative: a multiple of the
+                // divisor below zero has the remainder negative zero.
+                if ( a.min < 0 )
+                    break;
+
+                if ( b.min > 0 )
+                    range = code_generation::integer_range{ 0, std::min( a.max, b.max - 1 ) };
+                else if ( b.max < 0 )
+                    range = code_generation::integer_range{ b.min + 1, 0 };
+
+                break;
+            }
+
+            case ast::binary_operator::equal:
+            case ast::binary_operator::not_equal:
+            case ast::binary_operator::less:
+            case ast::binary_operator::less_equal:
+            case ast::binary_operator::greater:
+            case ast::binary_operator::greater_equal:
+                range = code_generation::integer_range{ std::min( a.min, b.min ), std::max( a.max, b.max ) };
+                break;
+
+            // Division and powers are not integers in general
+            default: return nullptr;
+        }
+
+        if ( !range )
+            return nullptr;
+
+        // The operation is done on the widest of the types, where all of them fit
+        llvm::Type* type = gen.get_integer_type( *range );
+
+        for ( llvm::Value* operand : { left, right } )
+        {
+            if ( operand->getType()->getIntegerBitWidth() > type->getIntegerBitWidth() )
+                type = operand->getType();
+        }
+
+        left = gen.convert( left, type );
+        right = gen.convert( right, type );
+
+        llvm::Value* result = nullptr;
+
+        switch ( op )
+        {
+            case ast::binary_operator::add: result = builder.CreateNSWAdd( left, right ); break;
+            case ast::binary_operator::subtract: result = builder.CreateNSWSub( left, right ); break;
+            case ast::binary_operator::multiply: result = builder.CreateNSWMul( left, right ); break;
+            case ast::binary_operator::modulo:
+            {
+                llvm::Value* remainder = builder.CreateSRem( left, right );
+                llvm::Value* zero = llvm::ConstantInt::get( type, 0 );
+
+                llvm::Value* adjust = builder.CreateAnd(
+                    builder.CreateICmpNE( remainder, zero ),
+                    builder.CreateXor(
+                        builder.CreateICmpSLT( remainder, zero ), builder.CreateICmpSLT( right, zero ) ) );
+
+                result = builder.CreateSelect( adjust, builder.CreateAdd( remainder, right ), remainder );
+                break;
+            }
+            case ast::binary_operator::equal: return builder.CreateICmpEQ( left, right );
+            case ast::binary_operator::not_equal: return builder.CreateICmpNE( left, right );
+            case ast::binary_operator::less: return builder.CreateICmpSLT( left, right );
+            case ast::binary_operator::less_equal: return builder.CreateICmpSLE( left, right );
+            case ast::binary_operator::greater: return builder.CreateICmpSGT( left, right );
+            default: return builder.CreateICmpSGE( left, right );
+        }
+
+        gen.set_range( result, *range );
+        return result;
+    }
+
+    llvm::Value* llvm_visitor::generate_logical( ast::binary_expression* node )
+    {
+        const bool is_and = node->op == ast::binary_operator::logical_and;
+        llvm::Value* left = generate( node->left.get() );
+
+        // Only booleans and nil can be false, any other value decides 'or' and leaves 'and' to the right operand
+        if ( !left->getType()->isIntegerTy( 1 ) && !gen.is_box( left ) )
+            return is_and ? generate( node->right.get() ) : left;
+
+        llvm::Value* condition = gen.is_truthy( left );
+
+        llvm::BasicBlock* from = builder.GetInsertBlock();
+        llvm::Function* function = from->getParent();
+
+        auto* evaluate = llvm::BasicBlock::Create( builder.getContext(), is_and ? "and.rhs" : "or.rhs", function );
+        auto* end = llvm::BasicBlock::Create( builder.getContext(), is_and ? "and.end" : "or.end", function );
+
+        if ( is_and )
+            builder.CreateCondBr( condition, evaluate, end );
+        else
+            builder.CreateCondBr( condition, end, evaluate );
+
+        builder.SetInsertPoint( evaluate );
+
+        llvm::Value* right = generate( node->right.get() );
+
+        // Numbers of different types are converted to the wider one, operands of other different types are boxed
+        llvm::Type* type = left->getType();
+
+        const auto is_number = [ this ]( llvm::Value* v ) { return gen.is_integer( v ) || v->getType()->isDoubleTy(); };
+
+        if ( right->getType() != type )
+        {
+            if ( gen.is_integer( left ) && gen.is_integer( right ) )
+                type = left->getType()->getIntegerBitWidth() > right->getType()->getIntegerBitWidth() ? left->getType()
+                                                                                                     : right->getType();
+            else if ( is_number( left ) && is_number( right ) )
+                type = builder.getDoubleTy();
+            else
+                type = gen.box( right )->getType();
+        }
+
+        // Known before the operands are converted
+        const bool integer = gen.is_integer( left ) && gen.is_integer( right );
+        const auto left_range = integer ? gen.get_range( left ) : code_generation::integer_range{};
+        const auto right_range = integer ? gen.get_range( right ) : code_generation::integer_range{};
+
+        if ( right->getType() != type )
+            right = gen.convert( right, type );
+
+        if ( left->getType() != type )
+        {
+            llvm::BasicBlock* current = builder.GetInsertBlock();
+
+            // The left operand is converted before the branch, where it may decide the result
+            builder.SetInsertPoint( from->getTerminator() );
+            left = gen.convert( left, type );
+            builder.SetInsertPoint( current );
+        }
+
+        llvm::BasicBlock* evaluated = builder.GetInsertBlock();
+        builder.CreateBr( end );
+
+        builder.SetInsertPoint( end );
+
+        llvm::PHINode* result = builder.CreatePHI( type, 2 );
+        result->addIncoming( left, from );
+        result->addIncoming( right, evaluated );
+
+        if ( integer )
+            gen.set_range(
+                result,
+                { std::min( left_range.min, right_range.min ), std::max( left_range.max, right_range.max ) } );
+
+        return result;
+    }
+}  // namespace lorraine::code_generation
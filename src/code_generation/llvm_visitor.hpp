@@ -19,13 +19,33 @@ namespace lorraine::code_generation
         bool visit( ast::number_literal* node ) override;
         bool visit( ast::string_literal* node ) override;
         bool visit( ast::boolean_literal* node ) override;
+        bool visit( ast::nil_literal* node ) override;
         bool visit( ast::call* node ) override;
         bool visit( ast::variable_reference* node ) override;
+        bool visit( ast::name_index* node ) override;
+        bool visit( ast::expression_index* node ) override;
+        bool visit( ast::expression_group* node ) override;
+        bool visit( ast::binary_expression* node ) override;
+        bool visit( ast::unary_expression* node ) override;
+        bool visit( ast::list_constructor* node ) override;
+        bool visit( ast::local_assignment* node ) override;
 
        private:
         llvm::IRBuilder<>& builder;
         llvm::Value* value;
         code_generation& gen;
+
+        /// @brief Generates the value of an expression
+        llvm::Value* generate( ast::expression* node );
+
+        /// @brief Generates an operator on two numbers that are lowered to integers, if its result provably is an
+        /// integer below code_generation::max_integer
+        /// @return The result, nullptr if the operation has to be done on doubles
+        llvm::Value* generate_integer( ast::binary_operator op, llvm::Value* left, llvm::Value* right );
+
+        /// @brief Generates 'and' and 'or', the right operand is only evaluated if the left one does not decide the
+        /// result
+        llvm::Value* generate_logical( ast::binary_expression* node );
     };
 
     class llvm_collector : public ast::visitor
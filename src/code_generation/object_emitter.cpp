@@ -0,0 +1,91 @@
+#include "object_emitter.hpp"
+
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/Host.h>
+
+#include "../cache/object_cache.hpp"
+#include "../utils/error.hpp"
+#include "targets.hpp"
+
+namespace lorraine::code_generation
+{
+    object_emitter::object_emitter( const std::string& triple, const std::string& cpu, int optimization_level )
+        : object_emitter( create_target_machine( triple, cpu, optimization_level ), optimization_level )
+    {
+    }
+
+    object_emitter::object_emitter( std::unique_ptr< llvm::TargetMachine > machine, int optimization_level )
+        : machine( std::move( machine ) ),
+          optimization_level( optimization_level )
+    {
+    }
+
+    std::unique_ptr< llvm::TargetMachine > object_emitter::create_target_machine(
+        const std::string& triple,
+        const std::string& cpu,
+        int optimization_level )
+    {
+        targets::initialize( triple );
+
+        const std::string target_triple = triple.empty() ? llvm::sys::getDefaultTargetTriple() : triple;
+
+        std::string error;
+        const llvm::Target* target = llvm::TargetRegistry::lookupTarget( target_triple, error );
+
+        if ( !target )
+            throw utils::compiler_error( error );
+
+        llvm::CodeGenOpt::Level level = llvm::CodeGenOpt::None;
+
+        switch ( optimization_level )
+        {
+            case 0: level = llvm::CodeGenOpt::None; break;
+            case 1: level = llvm::CodeGenOpt::Less; break;
+            case 2: level = llvm::CodeGenOpt::Default; break;
+            default: level = llvm::CodeGenOpt::Aggressive; break;
+        }
+
+        std::unique_ptr< llvm::TargetMachine > machine( target->createTargetMachine(
+            target_triple, cpu, "", llvm::TargetOptions{}, llvm::Reloc::PIC_, llvm::None, level ) );
+
+        if ( !machine )
+            throw utils::compiler_error( "unable to create a target machine for '" + target_triple + "'" );
+
+        return machine;
+    }
+
+    std::unique_ptr< llvm::TargetMachine > object_emitter::release()
+    {
+        return std::move( machine );
+    }
+
+    void object_emitter::configure( llvm::Module& module ) const
+    {
+        module.setTargetTriple( machine->getTargetTriple().str() );
+        module.setDataLayout( machine->createDataLayout() );
+    }
+
+    std::unique_ptr< llvm::MemoryBuffer > object_emitter::emit( llvm::Module& module, llvm::ObjectCache* cache )
+    {
+        configure( module );
+
+        llvm::orc::SimpleCompiler compiler( *machine, cache );
+
+        auto object = compiler( module );
+
+        if ( !object )
+            throw utils::compiler_error( llvm::toString( object.takeError() ) );
+
+        return std::move( *object );
+    }
+
+    std::string object_emitter::get_target_key() const
+    {
+        return cache::object_cache::get_target_key(
+            machine->getTargetTriple().str(),
+            machine->getTargetCPU().str(),
+            machine->getTargetFeatureString().str(),
+            optimization_level );
+    }
+}  // namespace lorraine::code_generation
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <string>
+
+namespace lorraine::code_generation
+{
+    /// @brief Compiles LLVM modules to native object files (ahead of time compilation)
+    class object_emitter final
+    {
+       public:
+        /// @brief Creates a new object emitter
+        /// @param triple Target triple, the host triple is used if empty
+        /// @param cpu Target CPU
+        /// @param optimization_level Optimization level from 0 to 3
+        explicit object_emitter( const std::string& triple, const std::string& cpu, int optimization_level );
+
+        /// @brief Creates a new object emitter that uses an existing target machine
+        /// @param machine Target machine (see create_target_machine)
+        /// @param optimization_level Optimization level the target machine was created with
+        explicit object_emitter( std::unique_ptr< llvm::TargetMachine > machine, int optimization_level );
+
+        /// @brief Creates a target machine for object emission
+        /// @param triple Target triple, the host triple is used if empty
+        /// @param cpu Target CPU
+        /// @param optimization_level Optimization level from 0 to 3
+        /// @return The target machine
+        static std::unique_ptr< llvm::TargetMachine > create_target_machine(
+            const std::string& triple,
+            const std::string& cpu,
+            int optimization_level );
+
+        /// @brief Hands the target machine back to the caller (e.g. to reuse it for another emitter). The emitter can
+        /// not be used afterwards.
+        /// @return The target machine
+        std::unique_ptr< llvm::TargetMachine > release();
+
+        /// @brief Sets the target triple and data layout of a module. Should be called before the module is optimized.
+        /// @param module The module
+        void configure( llvm::Module& module ) const;
+
+        /// @brief Compiles a module to an object file
+        /// @param module The module, it is configured automatically
+        /// @param cache Object cache that is consulted before the module is compiled (optional)
+        /// @return Object file
+        std::unique_ptr< llvm::MemoryBuffer > emit( llvm::Module& module, llvm::ObjectCache* cache = nullptr );
+
+        /// @brief Gets the description of the target used in object cache keys
+        /// @return Target key
+        std::string get_target_key() const;
+
+       private:
+        std::unique_ptr< llvm::TargetMachine > machine;
+        int optimization_level;
+    };
+}  // namespace lorraine::code_generation
@@ -0,0 +1,49 @@
+#include "optimizer.hpp"
+
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Scalar/ConstraintElimination.h>
+#include <llvm/Transforms/Scalar/InductiveRangeCheckElimination.h>
+
+namespace lorraine::code_generation
+{
+    void optimizer::optimize( llvm::Module& module, unsigned level )
+    {
+        // Level zero means the module is emitted exactly as it was generated
+        if ( level == 0 )
+            return;
+
+        llvm::LoopAnalysisManager loop_manager;
+        llvm::FunctionAnalysisManager function_manager;
+        llvm::CGSCCAnalysisManager cgscc_manager;
+        llvm::ModuleAnalysisManager module_manager;
+
+        llvm::PassBuilder builder;
+
+        builder.registerModuleAnalyses( module_manager );
+        builder.registerCGSCCAnalyses( cgscc_manager );
+        builder.registerFunctionAnalyses( function_manager );
+        builder.registerLoopAnalyses( loop_manager );
+        builder.crossRegisterProxies( loop_manager, function_manager, cgscc_manager, module_manager );
+
+        llvm::OptimizationLevel optimization_level = llvm::OptimizationLevel::O1;
+
+        if ( level == 2 )
+            optimization_level = llvm::OptimizationLevel::O2;
+        else if ( level >= 3 )
+            optimization_level = llvm::OptimizationLevel::O3;
+
+        // Bounds checks of arrays (see code_generation::get_element) are removed before loops are vectorized: the
+        // ones implied by a check that dominates them, and the ones of induction variables in the iterations where
+        // they provably hold (the loop is split into iterations with and without the checks)
+        builder.registerVectorizerStartEPCallback(
+            []( llvm::FunctionPassManager& function_passes, llvm::OptimizationLevel )
+            {
+                function_passes.addPass( llvm::ConstraintEliminationPass() );
+                function_passes.addPass( llvm::IRCEPass() );
+            } );
+
+        llvm::ModulePassManager passes = builder.buildPerModuleDefaultPipeline( optimization_level );
+        passes.run( module, module_manager );
+    }
+}  // namespace lorraine::code_generation
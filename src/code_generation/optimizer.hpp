@@ -0,0 +1,15 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+
+namespace lorraine::code_generation
+{
+    class optimizer final
+    {
+       public:
+        /// @brief Runs the default LLVM optimization pipeline over a module
+        /// @param module The module to optimize (modified in place)
+        /// @param level Optimization level from 0 (none) to 3 (aggressive)
+        static void optimize( llvm::Module& module, unsigned level );
+    };
+}  // namespace lorraine::code_generation
@@ -0,0 +1,53 @@
+#include "targets.hpp"
+
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <mutex>
+
+#include "../utils/error.hpp"
+
+namespace lorraine::code_generation
+{
+    void targets::initialize_native()
+    {
+        static std::once_flag initialized;
+
+        std::call_once(
+            initialized,
+            []()
+            {
+                llvm::InitializeNativeTarget();
+                llvm::InitializeNativeTargetAsmPrinter();
+                llvm::InitializeNativeTargetAsmParser();
+            } );
+    }
+
+    void targets::initialize( const std::string& triple )
+    {
+        initialize_native();
+
+        // The native target covers the host and its close relatives (e.g. i386 on x86_64)
+        std::string error;
+
+        if ( triple.empty() || llvm::TargetRegistry::lookupTarget( triple, error ) )
+            return;
+
+#ifdef LORRAINE_HOST_ONLY
+        throw utils::compiler_error( "unsupported target '" + triple + "', this compiler was built for the host only" );
+#else
+        static std::once_flag initialized;
+
+        std::call_once(
+            initialized,
+            []()
+            {
+                llvm::InitializeAllTargetInfos();
+                llvm::InitializeAllTargets();
+                llvm::InitializeAllTargetMCs();
+                llvm::InitializeAllAsmParsers();
+                llvm::InitializeAllAsmPrinters();
+            } );
+#endif
+    }
+}  // namespace lorraine::code_generation
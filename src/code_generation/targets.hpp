@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace lorraine::code_generation
+{
+    /// @brief Registers LLVM targets on demand. Only stages that emit machine code need a target, and registering
+    /// every backend LLVM was built with is expensive, so targets are registered the first time they are needed and
+    /// only the native one unless another target is requested. All methods are thread safe.
+    class targets final
+    {
+       public:
+        /// @brief Registers the target of the host (once per process)
+        static void initialize_native();
+
+        /// @brief Registers the target of a triple (once per process)
+        /// @param triple Target triple, the host is used if empty
+        static void initialize( const std::string& triple );
+    };
+}  // namespace lorraine::code_generation
@@ -1,54 +1,317 @@
 #include "compiler.hpp"
 
+#include <llvm/ADT/SmallString.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
 #include <llvm/Support/Program.h>
 #include <llvm/Support/WithColor.h>
+#include <llvm/Support/raw_ostream.h>
 
+#include <optional>
+
+#include "../ast/folder.hpp"
 #include "../ast/type/validator.hpp"
+#include "../cache/hash.hpp"
+#include "../cache/interface.hpp"
+#include "../cache/object_cache.hpp"
+#include "../cache/store.hpp"
 #include "../code_generation/code_generation.hpp"
+#include "../code_generation/object_emitter.hpp"
+#include "../code_generation/optimizer.hpp"
+#include "../jit/jit.hpp"
 #include "../lexer/lexer.hpp"
 #include "../parser/parser.hpp"
 
 namespace lorraine::compiler
 {
-    std::stringstream compiler::compile( const std::string& name, const std::string_view& source, compiler_stage stage )
+    compiler::compiler( const cli::config& cfg, std::shared_ptr< session > shared )
+        : cfg( cfg ),
+          shared( shared ? std::move( shared ) : std::make_shared< session >() ),
+          context( std::make_unique< llvm::LLVMContext >() )
+    {
+    }
+
+    compiler::~compiler() = default;
+
+    bool compiler::compile(
+        const std::string& name,
+        const std::string_view& source,
+        compiler_stage stage,
+        llvm::raw_ostream& out )
     {
         this->source = source;
 
         if ( stage == compiler_stage::lexer )
         {
-            lexer::lexer lexer( source, this );
+            try
+            {
+                lexer::lexer lexer( source, this, source.size() >= lexer::lexer::pipeline_threshold );
+                lexer.print_tokens( out );
+            }
+            catch ( const utils::syntax_error& error )
+            {
+                llvm_display_error( name, source, error );
+                return false;
+            }
 
-            return lexer.print_tokens();
+            return true;
         }
 
-        parser::parser parser( name, source, this );
+        // Huge (usually generated) sources never have their whole syntax tree in memory
+        if ( cfg.get< bool >( "streaming" ) )
+            return compile_statements( name, source, stage, out );
 
-        const auto main_module = parser.parse();
+        const auto main_module = parse( name, source );
+
+        return main_module && compile( *main_module, stage, out );
+    }
+
+    bool compiler::compile_statements(
+        const std::string& name,
+        const std::string_view& source,
+        compiler_stage stage,
+        llvm::raw_ostream& out )
+    {
+        std::optional< parser::parser > parser;
+
+        // The lexer reads the first token as it is created
+        try
+        {
+            parser.emplace( name, source, this );
+        }
+        catch ( const utils::syntax_error& error )
+        {
+            llvm_display_error( name, source, error );
+            return false;
+        }
+
+        const auto main_module = parser->parse_module_scope();
 
         if ( !main_module )
-            return {};
+            return false;
+
+        code_generation::code_generation gen{ main_module.get(), *context };
+        ast::folder folder;
+        std::unique_ptr< ast::statement > statement;
+
+        // Every statement is destroyed as soon as its code was generated, only the module scope is kept
+        while ( parser->parse_next( statement ) )
+        {
+            if ( !statement )
+            {
+                emit( *gen.finish(), stage, out );
+                return true;
+            }
+
+            if ( !ast::type::validator::validate( statement.get(), main_module.get(), this ) )
+                return false;
+
+            folder.fold( statement.get() );
+            gen.generate( statement.get() );
+        }
+
+        return false;
+    }
+
+    bool compiler::compile( ast::module& main_module, compiler_stage stage, llvm::raw_ostream& out )
+    {
+        this->source = main_module.info->source;
+
+        // Modules are validated even if they are served from the cache, so that everything the validator reports is
+        // reported again. It is cheap compared to generating code.
+        if ( !ast::type::validator::validate( &main_module, this ) )
+            return false;
+
+        // Modules that did not change since they were last compiled are served from the cache, without being
+        // compiled again.
+        std::string key;
+        const auto store = get_cache();
+
+        if ( store )
+        {
+            key = "outputs/" + get_cache_key( main_module, stage );
+
+            if ( const auto output = store->load( key ) )
+            {
+                out << output->getBuffer();
+                return true;
+            }
+        }
+
+        ast::folder::fold( &main_module );
+
+        if ( !store )
+        {
+            generate( &main_module, stage, out );
+            return true;
+        }
+
+        // The output has to be kept in memory once to populate the cache
+        llvm::SmallString< 0 > output;
+        llvm::raw_svector_ostream buffer( output );
+
+        generate( &main_module, stage, buffer );
+
+        store->save( key, output );
+        out << output;
+
+        return true;
+    }
+
+    void compiler::generate( ast::module* main_module, compiler_stage stage, llvm::raw_ostream& out )
+    {
+        code_generation::code_generation gen{ main_module, *context };
+
+        emit( *gen.generate(), stage, out );
+    }
+
+    void compiler::emit( llvm::Module& main, compiler_stage stage, llvm::raw_ostream& out )
+    {
+        if ( stage == compiler_stage::object )
+        {
+            const auto& triple = cfg.get< std::string >( "target" );
+            const auto& cpu = cfg.get< std::string >( "cpu" );
+            const int level = cfg.get< int >( "optimizationLevel" );
+
+            // Creating a target machine is expensive, so they are reused for every module of the session
+            const std::string machine_key = triple + '\n' + cpu + '\n' + std::to_string( level );
+            auto machine = shared->take_target_machine( machine_key );
+
+            if ( !machine )
+                machine = code_generation::object_emitter::create_target_machine( triple, cpu, level );
+
+            code_generation::object_emitter emitter{ std::move( machine ), level };
+
+            // The target has to be known before optimizing, as some passes depend on the data layout
+            emitter.configure( main );
+            code_generation::optimizer::optimize( main, cfg.get< int >( "optimizationLevel" ) );
+
+            std::unique_ptr< llvm::MemoryBuffer > object;
 
-        if ( !ast::type::validator::validate( main_module.get(), this ) )
-            return {};
+            if ( const auto store = get_cache() )
+            {
+                cache::object_cache objects{ *store, emitter.get_target_key() };
+                object = emitter.emit( main, &objects );
+            }
+            else
+                object = emitter.emit( main );
 
-        code_generation::code_generation gen{ main_module.get() };
-        std::shared_ptr< llvm::Module > main = gen.generate();
+            shared->return_target_machine( machine_key, emitter.release() );
+
+            out << object->getBuffer();
+            return;
+        }
+
+        code_generation::optimizer::optimize( main, cfg.get< int >( "optimizationLevel" ) );
 
         if ( stage == compiler_stage::ir )
+            main.print( out, nullptr );
+        else
+            llvm::WriteBitcodeToFile( main, out );
+    }
+
+    int compiler::run( const std::string& name, const std::string_view& source )
+    {
+        const auto main_module = parse( name, source );
+
+        if ( !main_module || !ast::type::validator::validate( main_module.get(), this ) )
+            return 1;
+
+        ast::folder::fold( main_module.get() );
+
+        // The JIT takes ownership of the module, so it gets a context of its own
+        auto jit_context = std::make_unique< llvm::LLVMContext >();
+
+        code_generation::code_generation gen{ main_module.get(), *jit_context };
+        std::unique_ptr< llvm::Module > main = gen.generate();
+
+        jit::options options;
+        options.lazy = cfg.get< bool >( "lazyCompilation" );
+        options.speculative = cfg.get< bool >( "speculativeCompilation" );
+        options.optimization_level = cfg.get< int >( "optimizationLevel" );
+        options.cache = get_cache();
+
+        const auto jit = jit::jit::create( options );
+        jit->add_module( llvm::orc::ThreadSafeModule{ std::move( main ), std::move( jit_context ) } );
+
+        return jit->run();
+    }
+
+    std::unique_ptr< ast::module > compiler::parse( const std::string& name, const std::string_view& source )
+    {
+        this->source = source;
+
+        // The lexer reads the first token as it is created
+        try
         {
-            std::string ss;
-            llvm::raw_string_ostream raw( ss );
-            main->print( raw, nullptr );
+            parser::parser parser( name, source, this );
 
-            return std::stringstream{ ss };
+            return parser.parse();
         }
+        catch ( const utils::syntax_error& error )
+        {
+            llvm_display_error( name, source, error );
+            return nullptr;
+        }
+    }
+
+    std::string compiler::get_cache_key( const ast::module& main_module, compiler_stage stage )
+    {
+        cache::hasher hash;
+
+        hash.update( get_settings_hash( stage ) );
+
+        // The module name ends up in the output (module identifier and source file name)
+        hash.update( main_module.info->name );
+        hash.update( main_module.info->absolute() );
+        hash.update( main_module.info->source );
+
+        // Everything the module can see from other modules: the imports and the built-in type definitions
+        hash.update( cache::get_imports_hash( main_module ) );
+
+        if ( const auto array = main_module.body->get_type( "Array" ) )
+            hash.update( cache::describe( *array ) );
+
+        return hash.digest();
+    }
+
+    std::string compiler::get_settings_hash( compiler_stage stage )
+    {
+        cache::hasher hash;
+
+        hash.update( std::string_view{ LORRAINE_VERSION } );
+        hash.update( std::string_view{ LLVM_VERSION_STRING } );
+        hash.update( static_cast< int >( stage ) );
+
+        // Options that change how the code is checked or generated
+        hash.update( cfg.get< bool >( "imbalancedLocalAssignments" ) );
+        hash.update( cfg.get< bool >( "allowTypelessFunctions" ) );
+        hash.update( cfg.get< std::string >( "pathToTypeDefinitions" ) );
+        hash.update( cfg.get< int >( "optimizationLevel" ) );
+        hash.update( cfg.get< std::string >( "target" ) );
+        hash.update( cfg.get< std::string >( "cpu" ) );
+
+        return hash.digest();
+    }
+
+    cache::store* compiler::get_cache()
+    {
+        return shared->get_cache( cfg );
+    }
+
+    std::shared_ptr< ast::module > compiler::get_shared_module(
+        const std::string& name,
+        const std::function< std::unique_ptr< ast::module >() >& load )
+    {
+        // Compilers of the session can be configured differently (e.g. clients of a daemon), the options that change
+        // how a module is parsed and checked are part of its key
+        cache::hasher hash;
 
-        std::string ss;
-        llvm::raw_string_ostream raw( ss );
-        llvm::WriteBitcodeToFile( *main, raw );
+        hash.update( cfg.get< bool >( "imbalancedLocalAssignments" ) );
+        hash.update( cfg.get< bool >( "allowTypelessFunctions" ) );
+        hash.update( cfg.get< std::string >( "pathToTypeDefinitions" ) );
 
-        return std::stringstream{ ss };
+        return shared->get_module( hash.digest() + ':' + name, load );
     }
 
     void compiler::llvm_display_error(
@@ -56,6 +319,8 @@ namespace lorraine::compiler
         const std::string_view& source,
         const utils::syntax_error& error )
     {
+        std::lock_guard< std::mutex > lock( shared->diagnostics );
+
         llvm::errs() << name << ':' << error.location.start.line << ':' << error.location.start.column + 1 << ": ";
         llvm::WithColor::error();
 
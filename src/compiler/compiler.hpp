@@ -1,12 +1,20 @@
 #pragma once
 
+#include <functional>
 #include <memory>
-#include <sstream>
 #include <string_view>
 #include <vector>
 
 #include "../cli/config.hpp"
 #include "../utils/error.hpp"
+#include "session.hpp"
+
+namespace llvm
+{
+    class LLVMContext;
+    class Module;
+    class raw_ostream;
+}  // namespace llvm
 
 namespace lorraine::compiler
 {
@@ -16,25 +24,65 @@ namespace lorraine::compiler
         parser,
         type,
         ir,
-        codegen
+        codegen,
+        object
     };
 
     class compiler final
     {
        public:
-        explicit compiler( const cli::config& cfg ) : cfg( cfg )
-        {
-        }
+        /// @brief Creates a new compiler. A compiler compiles one module at a time, use one compiler per thread.
+        /// @param cfg Compiler configuration
+        /// @param shared State shared with other compilers, a new session is created if none is given
+        explicit compiler( const cli::config& cfg, std::shared_ptr< session > shared = nullptr );
+
+        ~compiler();
 
         /// @brief Compiles the given source
         /// @param name The name of the module we are currentlyu compiling
         /// @param source Code to compile
         /// @param stage Stage the compiler will stop at and generate output for
-        /// @return Output stream
-        std::stringstream compile(
+        /// @param out The stream the output is written to
+        /// @return False if an error was reported
+        bool compile(
             const std::string& name,
             const std::string_view& source,
-            compiler_stage stage = compiler_stage::codegen );
+            compiler_stage stage,
+            llvm::raw_ostream& out );
+
+        /// @brief Validates and compiles a module that was already parsed
+        /// @param main_module The module
+        /// @param stage Stage the compiler will stop at and generate output for
+        /// @param out The stream the output is written to, nothing is written if an error was reported
+        /// @return False if an error was reported
+        bool compile( ast::module& main_module, compiler_stage stage, llvm::raw_ostream& out );
+
+        /// @brief Parses the given source
+        /// @param name The name of the module (path relative to the working directory)
+        /// @param source Code to parse
+        /// @return Module or nullptr if an error was reported
+        std::unique_ptr< ast::module > parse( const std::string& name, const std::string_view& source );
+
+        /// @brief Hashes everything besides the source that affects the output of a stage: the compiler version and
+        /// the options that change how code is checked or generated
+        /// @param stage Stage the output is generated for
+        /// @return Hexadecimal hash
+        std::string get_settings_hash( compiler_stage stage );
+
+        /// @brief Gets a module that is shared by all compilers of the session with the same options that affect
+        /// parsing (see session::get_module)
+        /// @param name Name of the module
+        /// @param load Parses the module if it was not loaded yet
+        /// @return The module
+        std::shared_ptr< ast::module > get_shared_module(
+            const std::string& name,
+            const std::function< std::unique_ptr< ast::module >() >& load );
+
+        /// @brief Compiles the given source with the JIT compiler and runs its entry function
+        /// @param name The name of the module we are currently running
+        /// @param source Code to run
+        /// @return Exit code of the program (non-zero if the program failed to compile)
+        int run( const std::string& name, const std::string_view& source );
 
         void llvm_display_error(
             const std::string& name,
@@ -46,6 +94,48 @@ namespace lorraine::compiler
        private:
         std::string_view source;
 
+        /// @brief Parses, validates and generates the source one top-level statement at a time, so that only one
+        /// statement's syntax tree is held in memory at once. The output is not cached.
+        /// @param name The name of the module
+        /// @param source Code to compile
+        /// @param stage Stage that determines the kind of output (IR, bitcode or object)
+        /// @param out The stream the output is written to, nothing is written if an error was reported
+        /// @return False if an error was reported
+        bool compile_statements(
+            const std::string& name,
+            const std::string_view& source,
+            compiler_stage stage,
+            llvm::raw_ostream& out );
+
+        /// @brief Generates the output of a validated module
+        /// @param main_module The module
+        /// @param stage Stage that determines the kind of output (IR, bitcode or object)
+        /// @param out The stream the output is written to
+        void generate( ast::module* main_module, compiler_stage stage, llvm::raw_ostream& out );
+
+        /// @brief Optimizes a generated module and writes the output of a stage
+        /// @param main The generated module
+        /// @param stage Stage that determines the kind of output (IR, bitcode or object)
+        /// @param out The stream the output is written to
+        void emit( llvm::Module& main, compiler_stage stage, llvm::raw_ostream& out );
+
+        /// @brief Builds the key of a module in the compilation cache. It covers the compiler version, the source, the
+        /// interfaces of all (transitively) imported modules and every option that affects the output.
+        /// @param main_module The parsed module
+        /// @param stage Stage the output is generated for
+        /// @return Hexadecimal key
+        std::string get_cache_key( const ast::module& main_module, compiler_stage stage );
+
         std::vector< std::shared_ptr< utils::error > > errors;
+
+        std::shared_ptr< session > shared;
+
+        /// @brief Context of the modules generated by this compiler. It is reused for every module, so compilers must
+        /// not be shared between threads.
+        std::unique_ptr< llvm::LLVMContext > context;
+
+        /// @brief Gets the on-disk build cache of the session
+        /// @return The cache or nullptr if caching is disabled
+        cache::store* get_cache();
     };
 }  // namespace lorraine::compiler
\ No newline at end of file
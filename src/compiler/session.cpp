@@ -0,0 +1,116 @@
+#include "session.hpp"
+
+#include <llvm/Target/TargetMachine.h>
+
+#include "../ast/statement.hpp"
+#include "../cache/store.hpp"
+
+namespace lorraine::compiler
+{
+    namespace
+    {
+        std::filesystem::file_time_type get_modification_time( const ast::module& module )
+        {
+            std::error_code error;
+            return std::filesystem::last_write_time( module.info->absolute(), error );
+        }
+    }  // namespace
+
+    session::session() = default;
+
+    session::~session() = default;
+
+    cache::store* session::get_cache( cli::config& cfg )
+    {
+        if ( !cfg.get< bool >( "cache" ) )
+            return nullptr;
+
+        const auto& directory = cfg.get< std::string >( "cacheDirectory" );
+        const std::uintmax_t size = static_cast< std::uintmax_t >( cfg.get< int >( "cacheSize" ) ) * 1024 * 1024;
+
+        std::lock_guard< std::mutex > lock( caches_mutex );
+
+        auto& store = caches[ { directory, size } ];
+
+        if ( !store )
+            store = std::make_unique< cache::store >(
+                directory.empty() ? cache::store::get_default_directory() : std::filesystem::path{ directory }, size );
+
+        return store.get();
+    }
+
+    std::shared_ptr< ast::module > session::get_module(
+        const std::string& name,
+        const std::function< std::unique_ptr< ast::module >() >& load )
+    {
+        std::lock_guard< std::recursive_mutex > lock( modules_mutex );
+
+        std::shared_ptr< ast::module > module;
+
+        // Compilers that are done with an outdated module keep their reference, so it can be replaced safely
+        if ( is_current( name ) )
+            module = modules.at( name ).module;
+        else
+        {
+            loading.emplace_back();
+
+            try
+            {
+                module = load();
+            }
+            catch ( ... )
+            {
+                loading.pop_back();
+                throw;
+            }
+
+            modules[ name ] = shared_module{ module, get_modification_time( *module ), std::move( loading.back() ) };
+            loading.pop_back();
+        }
+
+        // The module that is being loaded imports this one
+        if ( !loading.empty() )
+            loading.back().emplace_back( name, module );
+
+        return module;
+    }
+
+    bool session::is_current( const std::string& name )
+    {
+        const auto it = modules.find( name );
+
+        if ( it == modules.end() || get_modification_time( *it->second.module ) != it->second.modified )
+            return false;
+
+        // An import that changed is loaded again, which makes this module outdated too
+        for ( const auto& [ import, module ] : it->second.imports )
+        {
+            if ( !is_current( import ) || modules.at( import ).module != module )
+                return false;
+        }
+
+        return true;
+    }
+
+    std::unique_ptr< llvm::TargetMachine > session::take_target_machine( const std::string& key )
+    {
+        std::lock_guard< std::mutex > lock( machines_mutex );
+
+        const auto it = machines.find( key );
+
+        if ( it == machines.end() )
+            return nullptr;
+
+        auto machine = std::move( it->second );
+        machines.erase( it );
+
+        return machine;
+    }
+
+    void session::return_target_machine( const std::string& key, std::unique_ptr< llvm::TargetMachine > machine )
+    {
+        std::lock_guard< std::mutex > lock( machines_mutex );
+
+        machines.emplace( key, std::move( machine ) );
+    }
+}  // namespace lorraine::compiler
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../cli/config.hpp"
+
+namespace llvm
+{
+    class TargetMachine;
+}  // namespace llvm
+
+namespace lorraine::ast
+{
+    struct module;
+}  // namespace lorraine::ast
+
+namespace lorraine::cache
+{
+    class store;
+}  // namespace lorraine::cache
+
+namespace lorraine::compiler
+{
+    /// @brief State that is shared by every compiler of a process, e.g. the workers of a batch compilation or the
+    /// requests of a daemon. Each compiler still owns everything that is not thread safe (its LLVM context, the
+    /// module being compiled); the session only holds things that are expensive to set up and safe to share. All
+    /// methods are thread safe.
+    class session final
+    {
+       public:
+        session();
+
+        ~session();
+
+        /// @brief Gets the on-disk build cache, opening it on first use
+        /// @param cfg Configuration of the compiler, it determines the location and size of the cache
+        /// @return The cache or nullptr if caching is disabled
+        cache::store* get_cache( cli::config& cfg );
+
+        /// @brief Gets a module that is imported by every module of the session (e.g. the built-in type definitions).
+        /// It is only parsed again if its file, or a module it imported while it was loaded, was modified since, and
+        /// must not be modified by callers.
+        /// @param name Key of the module, its path and everything else its parsing depends on
+        /// @param load Parses the module, only called if the module was not loaded yet. Errors are not cached.
+        /// @return The module
+        std::shared_ptr< ast::module > get_module(
+            const std::string& name,
+            const std::function< std::unique_ptr< ast::module >() >& load );
+
+        /// @brief Takes an idle target machine out of the pool. Target machines can only be used by one thread at a
+        /// time, so every compiler takes its own and returns it when it is done.
+        /// @param key Describes the configuration of the target machine (triple, CPU, optimization level)
+        /// @return The target machine or nullptr if there is no idle one
+        std::unique_ptr< llvm::TargetMachine > take_target_machine( const std::string& key );
+
+        /// @brief Returns a target machine to the pool
+        /// @param key Key the target machine was taken with
+        /// @param machine The target machine
+        void return_target_machine( const std::string& key, std::unique_ptr< llvm::TargetMachine > machine );
+
+        /// @brief Held while printing diagnostics, so messages of different compilers do not interleave
+        std::mutex diagnostics;
+
+       private:
+        struct shared_module
+        {
+            std::shared_ptr< ast::module > module;
+            std::filesystem::file_time_type modified;
+
+            /// @brief The shared modules it imported, by their keys. Their types are part of this module.
+            std::vector< std::pair< std::string, std::shared_ptr< ast::module > > > imports;
+        };
+
+        /// @brief Checks if a loaded module and the modules it imported are still the ones their files contain
+        bool is_current( const std::string& name );
+
+        std::mutex caches_mutex;
+        std::map< std::pair< std::string, std::uintmax_t >, std::unique_ptr< cache::store > > caches;
+
+        /// @brief Loading a module can load other shared modules on the same thread
+        std::recursive_mutex modules_mutex;
+        std::unordered_map< std::string, shared_module > modules;
+
+        /// @brief The imports of the modules being loaded, innermost last
+        std::vector< std::vector< std::pair< std::string, std::shared_ptr< ast::module > > > > loading;
+
+        std::mutex machines_mutex;
+        std::unordered_multimap< std::string, std::unique_ptr< llvm::TargetMachine > > machines;
+    };
+}  // namespace lorraine::compiler
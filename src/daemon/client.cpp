@@ -0,0 +1,111 @@
+#include "client.hpp"
+
+#include <llvm/Support/WithColor.h>
+
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "protocol.hpp"
+
+namespace lorraine::daemon
+{
+    std::optional< int > client::forward( int argc, char* argv[] )
+    {
+        request message;
+        message.working_directory = std::filesystem::current_path().string();
+
+        bool connect = false;
+        std::filesystem::path socket_path = get_default_socket();
+
+        for ( int i = 1; i < argc; ++i )
+        {
+            const std::string argument = argv[ i ];
+
+            // Starting the daemon itself is never forwarded, and watching would keep the daemon from serving anyone
+            // else
+            if ( argument == "--daemon" || argument == "watch" )
+                return std::nullopt;
+
+            if ( argument == "--connect" )
+                connect = true;
+            else if ( argument == "--socket" && i + 1 < argc )
+                socket_path = argv[ i + 1 ];
+            else if ( argument.rfind( "--socket=", 0 ) == 0 )
+                socket_path = argument.substr( 9 );
+
+            message.arguments.push_back( argument );
+        }
+
+        if ( !connect )
+            return std::nullopt;
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if ( socket_path.string().size() >= sizeof( address.sun_path ) )
+            return std::nullopt;
+
+        std::strcpy( address.sun_path, socket_path.c_str() );
+
+        const int socket = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+        if ( socket < 0 )
+            return std::nullopt;
+
+        // No daemon is running, compile in this process instead
+        if ( ::connect( socket, reinterpret_cast< sockaddr* >( &address ), sizeof( address ) ) < 0 )
+        {
+            ::close( socket );
+            return std::nullopt;
+        }
+
+        // Our streams and command line only go to a daemon of our own
+        if ( !is_same_user( socket ) )
+        {
+            llvm::WithColor::warning() << "the daemon on '" << socket_path.string()
+                                       << "' runs as another user, compiling without it\n";
+
+            ::close( socket );
+            return std::nullopt;
+        }
+
+        const std::string payload = message.serialize();
+        const std::uint32_t size = static_cast< std::uint32_t >( payload.size() );
+
+        // The size goes out together with our standard streams
+        int descriptors[ forwarded_descriptors ] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+        char control[ CMSG_SPACE( sizeof( descriptors ) ) ]{};
+
+        iovec data{ const_cast< std::uint32_t* >( &size ), sizeof( size ) };
+
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof( control );
+
+        cmsghdr* rights = CMSG_FIRSTHDR( &header );
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN( sizeof( descriptors ) );
+        std::memcpy( CMSG_DATA( rights ), descriptors, sizeof( descriptors ) );
+
+        std::int32_t code = 1;
+
+        // Once the request is out, falling back would compile twice; a broken connection is a failed compilation
+        if ( ::sendmsg( socket, &header, MSG_NOSIGNAL ) != sizeof( size ) ||
+             !write_all( socket, payload.data(), payload.size() ) || !read_all( socket, &code, sizeof( code ) ) )
+        {
+            ::close( socket );
+            return 1;
+        }
+
+        ::close( socket );
+
+        return code;
+    }
+}  // namespace lorraine::daemon
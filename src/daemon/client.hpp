@@ -0,0 +1,20 @@
+#pragma once
+
+#include <optional>
+
+namespace lorraine::daemon
+{
+    /// @brief Thin client of the compile daemon. With '--connect' on the command line, the invocation is forwarded
+    /// to a running daemon (see server) instead of being compiled in this process.
+    class client final
+    {
+       public:
+        /// @brief Forwards the command line to the daemon and waits for the compilation to finish. Nothing is
+        /// initialized in this process, so this should be called before anything else.
+        /// @param argc The number of values in argv
+        /// @param argv The array of arguments
+        /// @return Exit code of the compilation, or std::nullopt if the invocation should be compiled in this process
+        /// (no '--connect' or no daemon is running)
+        static std::optional< int > forward( int argc, char* argv[] );
+    };
+}  // namespace lorraine::daemon
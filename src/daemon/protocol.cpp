@@ -0,0 +1,116 @@
+#include "protocol.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lorraine::daemon
+{
+    std::string request::serialize() const
+    {
+        std::string payload = working_directory;
+
+        for ( const auto& argument : arguments )
+        {
+            payload += '\0';
+            payload += argument;
+        }
+
+        return payload;
+    }
+
+    request request::deserialize( const std::string& payload )
+    {
+        request result;
+        std::size_t start = 0, end = payload.find( '\0' );
+
+        result.working_directory = payload.substr( 0, end );
+
+        while ( end != std::string::npos )
+        {
+            start = end + 1;
+            end = payload.find( '\0', start );
+
+            result.arguments.push_back( payload.substr( start, end == std::string::npos ? end : end - start ) );
+        }
+
+        return result;
+    }
+
+    std::filesystem::path get_default_socket()
+    {
+        if ( const char* runtime = std::getenv( "XDG_RUNTIME_DIR" ); runtime && *runtime )
+            return std::filesystem::path{ runtime } / "lorraine.sock";
+
+        // Anyone can create files in the temporary directory, the socket is in a directory of the user's own
+        return std::filesystem::temp_directory_path() / ( "lorraine-" + std::to_string( ::getuid() ) ) /
+               "lorraine.sock";
+    }
+
+    bool make_private_directory( const std::filesystem::path& directory )
+    {
+        if ( ::mkdir( directory.c_str(), 0700 ) < 0 && errno != EEXIST )
+            return false;
+
+        // An existing directory may have been created by someone else, it must not be a link either
+        struct stat status;
+
+        return ::lstat( directory.c_str(), &status ) == 0 && S_ISDIR( status.st_mode ) &&
+               status.st_uid == ::getuid() && ( status.st_mode & 077 ) == 0;
+    }
+
+    bool is_same_user( int socket )
+    {
+        ucred credentials{};
+        socklen_t length = sizeof( credentials );
+
+        return ::getsockopt( socket, SOL_SOCKET, SO_PEERCRED, &credentials, &length ) == 0 &&
+               credentials.uid == ::getuid();
+    }
+
+    bool write_all( int socket, const void* data, std::size_t size )
+    {
+        const auto* bytes = static_cast< const char* >( data );
+
+        while ( size > 0 )
+        {
+            // The other side may be gone, which must not kill the process with SIGPIPE
+            const ssize_t written = ::send( socket, bytes, size, MSG_NOSIGNAL );
+
+            if ( written < 0 && errno == EINTR )
+                continue;
+
+            if ( written <= 0 )
+                return false;
+
+            bytes += written;
+            size -= static_cast< std::size_t >( written );
+        }
+
+        return true;
+    }
+
+    bool read_all( int socket, void* data, std::size_t size )
+    {
+        auto* bytes = static_cast< char* >( data );
+
+        while ( size > 0 )
+        {
+            const ssize_t count = ::read( socket, bytes, size );
+
+            if ( count < 0 && errno == EINTR )
+                continue;
+
+            if ( count <= 0 )
+                return false;
+
+            bytes += count;
+            size -= static_cast< std::size_t >( count );
+        }
+
+        return true;
+    }
+}  // namespace lorraine::daemon
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace lorraine::daemon
+{
+    /// @brief A compile request as it is sent from the client to the daemon. The client's standard streams are sent
+    /// along with it as file descriptors, so the daemon can read input and write output and diagnostics directly.
+    ///
+    /// Wire format (both sides run on the same machine):
+    ///   client -> daemon: uint32 size, size bytes of NUL separated strings (working directory, arguments...)
+    ///                     plus the client's stdin, stdout and stderr attached to the first byte (SCM_RIGHTS)
+    ///   daemon -> client: int32 exit code
+    struct request
+    {
+        std::string working_directory;
+
+        /// @brief Command line arguments, without the program name
+        std::vector< std::string > arguments;
+
+        /// @brief Serializes the request into its payload
+        /// @return NUL separated strings
+        std::string serialize() const;
+
+        /// @brief Deserializes a request from its payload
+        /// @param payload NUL separated strings
+        /// @return The request
+        static request deserialize( const std::string& payload );
+    };
+
+    /// @brief Number of file descriptors sent with a request (stdin, stdout and stderr)
+    constexpr std::size_t forwarded_descriptors = 3;
+
+    /// @brief Gets the socket the daemon listens on if none is given: $XDG_RUNTIME_DIR/lorraine.sock or
+    /// /tmp/lorraine-<uid>/lorraine.sock. Both directories are only accessible by the user.
+    /// @return Socket path
+    std::filesystem::path get_default_socket();
+
+    /// @brief Creates a directory only the current user can access, or checks that an existing one is
+    /// @param directory The directory
+    /// @return False if the directory could not be created or belongs to, or is accessible by, someone else
+    bool make_private_directory( const std::filesystem::path& directory );
+
+    /// @brief Checks that the process on the other end of a connection runs as the same user as this one. The
+    /// standard streams and the command line are only ever sent to and accepted from the same user.
+    /// @param socket The connected socket
+    /// @return True if the peer has the same user id
+    bool is_same_user( int socket );
+
+    /// @brief Writes a whole buffer to a socket, retrying on partial writes
+    /// @return False if the connection failed
+    bool write_all( int socket, const void* data, std::size_t size );
+
+    /// @brief Reads a whole buffer from a socket, retrying on partial reads
+    /// @return False if the connection failed or was closed early
+    bool read_all( int socket, void* data, std::size_t size );
+}  // namespace lorraine::daemon
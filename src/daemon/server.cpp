@@ -0,0 +1,245 @@
+#include "server.hpp"
+
+#include <llvm/Support/WithColor.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../cli/cli.hpp"
+#include "protocol.hpp"
+
+namespace lorraine::daemon
+{
+    server::server( const std::filesystem::path& socket )
+        : socket( socket ),
+          shared( std::make_shared< compiler::session >() )
+    {
+    }
+
+    server::~server()
+    {
+        if ( listener >= 0 )
+        {
+            ::close( listener );
+
+            std::error_code error;
+            std::filesystem::remove( socket, error );
+        }
+    }
+
+    int server::run()
+    {
+        if ( !listen() )
+            return 1;
+
+        // Clients may go away in the middle of a compilation, writing to their streams must not kill the daemon
+        std::signal( SIGPIPE, SIG_IGN );
+
+        llvm::errs() << "lorraine: listening on " << socket.string() << '\n';
+
+        while ( true )
+        {
+            const int connection = ::accept4( listener, nullptr, nullptr, SOCK_CLOEXEC );
+
+            if ( connection < 0 )
+            {
+                if ( errno == EINTR )
+                    continue;
+
+                llvm::WithColor::error() << "unable to accept connection: " << std::strerror( errno ) << '\n';
+                return 1;
+            }
+
+            if ( is_same_user( connection ) )
+                handle( connection );
+            else
+                llvm::WithColor::warning() << "rejected a connection of another user\n";
+
+            ::close( connection );
+        }
+    }
+
+    bool server::listen()
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if ( socket.string().size() >= sizeof( address.sun_path ) )
+        {
+            llvm::WithColor::error() << "socket path '" << socket.string() << "' is too long\n";
+            return false;
+        }
+
+        std::strcpy( address.sun_path, socket.c_str() );
+
+        // The default socket is in a directory of its own, which nobody else may be able to enter
+        if ( socket == get_default_socket() && !make_private_directory( socket.parent_path() ) )
+        {
+            llvm::WithColor::error() << "unable to use '" << socket.parent_path().string()
+                                     << "', it has to be a directory only the user can access\n";
+            return false;
+        }
+
+        listener = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+
+        if ( listener < 0 )
+        {
+            llvm::WithColor::error() << "unable to create socket: " << std::strerror( errno ) << '\n';
+            return false;
+        }
+
+        // A socket file nobody accepts connections on was left behind by a daemon that is gone
+        if ( std::filesystem::exists( socket ) )
+        {
+            if ( ::connect( listener, reinterpret_cast< sockaddr* >( &address ), sizeof( address ) ) == 0 )
+            {
+                llvm::WithColor::error() << "a daemon is already listening on '" << socket.string() << "'\n";
+
+                ::close( listener );
+                listener = -1;
+
+                return false;
+            }
+
+            std::error_code error;
+            std::filesystem::remove( socket, error );
+
+            ::close( listener );
+            listener = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+        }
+
+        if ( ::bind( listener, reinterpret_cast< sockaddr* >( &address ), sizeof( address ) ) < 0 ||
+             ::chmod( socket.c_str(), 0600 ) < 0 || ::listen( listener, SOMAXCONN ) < 0 )
+        {
+            llvm::WithColor::error() << "unable to listen on '" << socket.string() << "': " << std::strerror( errno )
+                                     << '\n';
+
+            ::close( listener );
+            listener = -1;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    void server::handle( int connection )
+    {
+        std::uint32_t size = 0;
+        char control[ CMSG_SPACE( sizeof( int ) * forwarded_descriptors ) ]{};
+
+        iovec data{ &size, sizeof( size ) };
+
+        msghdr header{};
+        header.msg_iov = &data;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof( control );
+
+        if ( ::recvmsg( connection, &header, MSG_CMSG_CLOEXEC ) != sizeof( size ) )
+            return;
+
+        const cmsghdr* rights = CMSG_FIRSTHDR( &header );
+
+        if ( !rights || rights->cmsg_level != SOL_SOCKET || rights->cmsg_type != SCM_RIGHTS ||
+             rights->cmsg_len != CMSG_LEN( sizeof( int ) * forwarded_descriptors ) )
+            return;
+
+        int streams[ forwarded_descriptors ];
+        std::memcpy( streams, CMSG_DATA( rights ), sizeof( streams ) );
+
+        std::string payload( size, '\0' );
+        std::int32_t code = 1;
+
+        if ( read_all( connection, payload.data(), payload.size() ) )
+        {
+            const auto message = request::deserialize( payload );
+            code = execute( message.working_directory, message.arguments, streams );
+        }
+
+        for ( const int stream : streams )
+            ::close( stream );
+
+        write_all( connection, &code, sizeof( code ) );
+    }
+
+    int server::execute(
+        const std::filesystem::path& working_directory,
+        const std::vector< std::string >& arguments,
+        const int ( &streams )[ 3 ] )
+    {
+        const auto daemon_directory = std::filesystem::current_path();
+
+        std::error_code error;
+        std::filesystem::current_path( working_directory, error );
+
+        if ( error )
+        {
+            const std::string message = "lorraine: unable to enter '" + working_directory.string() + "'\n";
+            ::write( streams[ 2 ], message.data(), message.size() );
+
+            return 1;
+        }
+
+        // Swap in the client's streams, keeping our own to restore them afterwards
+        int saved[ forwarded_descriptors ];
+
+        for ( std::size_t i = 0; i < forwarded_descriptors; ++i )
+        {
+            saved[ i ] = ::fcntl( static_cast< int >( i ), F_DUPFD_CLOEXEC, 0 );
+            ::dup2( streams[ i ], static_cast< int >( i ) );
+        }
+
+        std::cin.clear();
+
+        // The command line is parsed exactly like it would be by a compiler process of its own
+        std::vector< std::string > storage{ "lorraine" };
+        storage.insert( storage.end(), arguments.begin(), arguments.end() );
+
+        std::vector< char* > argv;
+
+        for ( auto& argument : storage )
+            argv.push_back( argument.data() );
+
+        argv.push_back( nullptr );
+
+        int code = 1;
+
+        try
+        {
+            cli::cli cli{ static_cast< int >( storage.size() ), argv.data(), shared };
+            code = cli.parse();
+        }
+        catch ( const std::exception& e )
+        {
+            llvm::WithColor::error() << e.what() << '\n';
+        }
+
+        // Programs run with the JIT write through C stdio
+        std::fflush( nullptr );
+        std::cout.flush();
+        std::cerr.flush();
+        llvm::outs().flush();
+        llvm::errs().flush();
+
+        for ( std::size_t i = 0; i < forwarded_descriptors; ++i )
+        {
+            ::dup2( saved[ i ], static_cast< int >( i ) );
+            ::close( saved[ i ] );
+        }
+
+        std::cin.clear();
+        std::filesystem::current_path( daemon_directory, error );
+
+        return code;
+    }
+}  // namespace lorraine::daemon
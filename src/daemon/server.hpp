@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include "../compiler/session.hpp"
+
+namespace lorraine::daemon
+{
+    /// @brief Resident compile server. It listens on a Unix socket and runs every forwarded command line (see client)
+    /// as if the compiler was started in the client's working directory with the client's standard streams.
+    ///
+    /// All requests share one session, so LLVM targets are only initialized once and the type definitions, target
+    /// machines and the build cache stay loaded between compilations. Requests are handled one at a time, as each
+    /// of them changes the working directory and standard streams of the process, so command lines that never end
+    /// ('watch') are not forwarded. Only connections of the user running the daemon are accepted.
+    class server final
+    {
+       public:
+        /// @brief Creates a new server
+        /// @param socket Path of the socket to listen on
+        explicit server( const std::filesystem::path& socket );
+
+        ~server();
+
+        /// @brief Listens for requests until the process is terminated
+        /// @return Process exit code (non-zero if the socket could not be opened)
+        int run();
+
+       private:
+        std::filesystem::path socket;
+        int listener = -1;
+
+        std::shared_ptr< compiler::session > shared;
+
+        /// @brief Opens the socket, replacing a stale socket file left behind by a daemon that is no longer running
+        /// @return False if the socket could not be opened
+        bool listen();
+
+        /// @brief Receives a request from a client, runs it and sends back the exit code
+        /// @param connection The client connection
+        void handle( int connection );
+
+        /// @brief Runs a command line with the standard streams redirected to the client's
+        /// @param working_directory Working directory of the client
+        /// @param arguments Command line arguments (without the program name)
+        /// @param streams The client's stdin, stdout and stderr
+        /// @return Exit code
+        int execute(
+            const std::filesystem::path& working_directory,
+            const std::vector< std::string >& arguments,
+            const int ( &streams )[ 3 ] );
+    };
+}  // namespace lorraine::daemon
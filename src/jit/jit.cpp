@@ -0,0 +1,173 @@
+#include "jit.hpp"
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutorProcessControl.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/SpeculateAnalyses.h>
+#include <llvm/ExecutionEngine/Orc/TaskDispatch.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Support/WithColor.h>
+
+#include "../code_generation/optimizer.hpp"
+#include "../code_generation/targets.hpp"
+#include "../utils/error.hpp"
+
+namespace lorraine::jit
+{
+    namespace
+    {
+        /// @brief Unwraps an LLVM expected value, converting failures into compiler errors
+        template< typename T >
+        T unwrap( llvm::Expected< T > value )
+        {
+            if ( !value )
+                throw utils::compiler_error( llvm::toString( value.takeError() ) );
+
+            return std::move( *value );
+        }
+
+        /// @brief Converts an LLVM error into a compiler error
+        void check( llvm::Error error )
+        {
+            if ( error )
+                throw utils::compiler_error( llvm::toString( std::move( error ) ) );
+        }
+
+        /// @brief Called from a lazy stub when the function behind it failed to compile. There is no caller we could
+        /// return an error to, so the only thing left to do is to exit.
+        void lazy_compile_failure()
+        {
+            llvm::WithColor::error() << "failed to compile function on demand\n";
+            std::exit( 1 );
+        }
+    }  // namespace
+
+    std::unique_ptr< jit > jit::create( const options& opts )
+    {
+        code_generation::targets::initialize_native();
+
+        // Speculative compilation hands its work to other threads, everything else runs on the calling thread.
+        std::unique_ptr< llvm::orc::TaskDispatcher > dispatcher =
+            std::make_unique< llvm::orc::InPlaceTaskDispatcher >();
+
+#if LLVM_ENABLE_THREADS
+        if ( opts.lazy && opts.speculative )
+            dispatcher = std::make_unique< llvm::orc::DynamicThreadPoolTaskDispatcher >();
+#endif
+
+        auto process = unwrap( llvm::orc::SelfExecutorProcessControl::Create( nullptr, std::move( dispatcher ) ) );
+        auto session = std::make_unique< llvm::orc::ExecutionSession >( std::move( process ) );
+
+        auto target_builder = unwrap( llvm::orc::JITTargetMachineBuilder::detectHost() );
+        target_builder.setCodeGenOptLevel(
+            opts.optimization_level == 0 ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Default );
+
+        auto data_layout = unwrap( target_builder.getDefaultDataLayoutForTarget() );
+
+        auto call_through = unwrap( llvm::orc::createLocalLazyCallThroughManager(
+            target_builder.getTargetTriple(),
+            *session,
+            llvm::pointerToJITTargetAddress( &lazy_compile_failure ) ) );
+
+        return std::unique_ptr< jit >( new jit(
+            std::move( session ), std::move( target_builder ), data_layout, std::move( call_through ), opts ) );
+    }
+
+    jit::jit(
+        std::unique_ptr< llvm::orc::ExecutionSession > session,
+        llvm::orc::JITTargetMachineBuilder target_builder,
+        llvm::DataLayout data_layout,
+        std::unique_ptr< llvm::orc::LazyCallThroughManager > call_through,
+        const options& opts )
+        : opts( opts ),
+          session( std::move( session ) ),
+          data_layout( std::move( data_layout ) ),
+          mangle( *this->session, this->data_layout ),
+          main_dylib( this->session->createBareJITDylib( "main" ) ),
+          objects(
+              opts.cache ? std::make_unique< cache::object_cache >(
+                               *opts.cache,
+                               cache::object_cache::get_target_key(
+                                   target_builder.getTargetTriple().str(),
+                                   target_builder.getCPU(),
+                                   target_builder.getFeatures().getString(),
+                                   opts.optimization_level ) )
+                         : nullptr ),
+          object_layer( *this->session, []() { return std::make_unique< llvm::SectionMemoryManager >(); } ),
+          compile_layer(
+              *this->session,
+              object_layer,
+              std::make_unique< llvm::orc::ConcurrentIRCompiler >( target_builder, objects.get() ) ),
+          speculator( implementations, *this->session ),
+          speculation_layer(
+              opts.lazy && opts.speculative ? std::make_unique< llvm::orc::IRSpeculationLayer >(
+                                                  *this->session,
+                                                  compile_layer,
+                                                  speculator,
+                                                  mangle,
+                                                  llvm::orc::BlockFreqQuery() )
+                                            : nullptr ),
+          optimize_layer(
+              *this->session,
+              speculation_layer ? static_cast< llvm::orc::IRLayer& >( *speculation_layer ) : compile_layer ),
+          call_through( std::move( call_through ) ),
+          lazy_layer(
+              *this->session,
+              optimize_layer,
+              *this->call_through,
+              llvm::orc::createLocalIndirectStubsManagerBuilder( target_builder.getTargetTriple() ) )
+    {
+        // Functions are optimized one partition at a time, right before they get compiled.
+        optimize_layer.setTransform(
+            [ level = opts.optimization_level ](
+                llvm::orc::ThreadSafeModule module,
+                llvm::orc::MaterializationResponsibility& ) -> llvm::Expected< llvm::orc::ThreadSafeModule >
+            {
+                module.withModuleDo(
+                    [ level ]( llvm::Module& m ) { code_generation::optimizer::optimize( m, level ); } );
+
+                return std::move( module );
+            } );
+
+        // Every function is its own partition, so only functions that are actually called get compiled.
+        lazy_layer.setPartitionFunction( llvm::orc::CompileOnDemandLayer::compileRequested );
+
+        if ( speculation_layer )
+        {
+            lazy_layer.setImplMap( &implementations );
+            check( speculator.addSpeculationRuntime( main_dylib, mangle ) );
+        }
+
+        // Resolve external declarations (e.g. 'extern printf') against the symbols of the current process.
+        main_dylib.addGenerator( unwrap(
+            llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess( this->data_layout.getGlobalPrefix() ) ) );
+    }
+
+    jit::~jit()
+    {
+        if ( auto error = session->endSession() )
+            session->reportError( std::move( error ) );
+    }
+
+    void jit::add_module( llvm::orc::ThreadSafeModule module )
+    {
+        module.withModuleDo( [ this ]( llvm::Module& m ) { m.setDataLayout( data_layout ); } );
+
+        if ( opts.lazy )
+            check( lazy_layer.add( main_dylib, std::move( module ) ) );
+        else
+            check( optimize_layer.add( main_dylib, std::move( module ) ) );
+    }
+
+    int jit::run( const std::string& entry )
+    {
+        const auto symbol = unwrap( session->lookup( { &main_dylib }, mangle( entry ) ) );
+
+        const auto function = llvm::jitTargetAddressToFunction< void ( * )() >( symbol.getAddress() );
+        function();
+
+        return 0;
+    }
+}  // namespace lorraine::jit
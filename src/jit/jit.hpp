@@ -0,0 +1,94 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/CompileOnDemandLayer.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/IRTransformLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LazyReexports.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/Speculation.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/DataLayout.h>
+
+#include <memory>
+#include <string>
+
+#include "../cache/object_cache.hpp"
+
+namespace lorraine::jit
+{
+    /// @brief Options that control when and how the JIT compiles code
+    struct options
+    {
+        /// @brief Compile each function the first time it is called instead of compiling whole modules up front
+        bool lazy = true;
+
+        /// @brief Compile functions that are likely to be called next on background threads (requires `lazy`)
+        bool speculative = false;
+
+        /// @brief Optimization level applied to every module (or lazily compiled function) before code generation
+        unsigned optimization_level = 0;
+
+        /// @brief Store for compiled objects. If set, functions that were compiled in an earlier run are loaded from
+        /// the cache instead of being compiled again.
+        cache::store* cache = nullptr;
+    };
+
+    /// @brief In-process JIT compiler built on top of LLVM's ORC layers. The layer stack looks like this:
+    ///
+    ///   compile-on-demand -> optimize -> (speculate) -> compile -> link
+    ///
+    /// With lazy compilation enabled, every function in an added module is replaced by a lazy re-export. Calling a
+    /// re-export jumps through a stub into the compile callback, which optimizes and compiles only that function and
+    /// then patches the stub so later calls go straight to the compiled code.
+    class jit final
+    {
+       public:
+        /// @brief Creates a new JIT targeting the host process
+        /// @param opts JIT options
+        /// @return New JIT instance
+        static std::unique_ptr< jit > create( const options& opts );
+
+        ~jit();
+
+        /// @brief Adds a module to the JIT. Nothing is compiled until a symbol of the module is looked up.
+        /// @param module The module and the context that owns it
+        void add_module( llvm::orc::ThreadSafeModule module );
+
+        /// @brief Looks up the entry function and calls it
+        /// @param entry Name of the entry function, it must take no arguments and return void
+        /// @return Process exit code
+        int run( const std::string& entry = "main" );
+
+       private:
+        explicit jit(
+            std::unique_ptr< llvm::orc::ExecutionSession > session,
+            llvm::orc::JITTargetMachineBuilder target_builder,
+            llvm::DataLayout data_layout,
+            std::unique_ptr< llvm::orc::LazyCallThroughManager > call_through,
+            const options& opts );
+
+        options opts;
+
+        std::unique_ptr< llvm::orc::ExecutionSession > session;
+        llvm::DataLayout data_layout;
+        llvm::orc::MangleAndInterner mangle;
+        llvm::orc::JITDylib& main_dylib;
+
+        std::unique_ptr< cache::object_cache > objects;
+
+        llvm::orc::RTDyldObjectLinkingLayer object_layer;
+        llvm::orc::IRCompileLayer compile_layer;
+
+        llvm::orc::ImplSymbolMap implementations;
+        llvm::orc::Speculator speculator;
+        std::unique_ptr< llvm::orc::IRSpeculationLayer > speculation_layer;
+
+        llvm::orc::IRTransformLayer optimize_layer;
+
+        std::unique_ptr< llvm::orc::LazyCallThroughManager > call_through;
+        llvm::orc::CompileOnDemandLayer lazy_layer;
+    };
+}  // namespace lorraine::jit
@@ -0,0 +1,172 @@
+#include "chunked_lexer.hpp"
+
+#include <algorithm>
+
+namespace lorraine::lexer
+{
+    namespace
+    {
+        /// @brief Moves a location down by a number of lines
+        void shift( utils::location& location, std::size_t lines )
+        {
+            location.start.line += lines;
+            location.end.line += lines;
+        }
+    }  // namespace
+
+    chunked_lexer::chunk::~chunk()
+    {
+        if ( worker.joinable() )
+            worker.join();
+    }
+
+    chunked_lexer::chunked_lexer( const std::string_view& source, compiler::compiler* compiler, unsigned jobs )
+        : source( source ),
+          compiler( compiler ),
+          jobs( std::max( 1u, jobs ) )
+    {
+    }
+
+    void chunked_lexer::run( token_queue& queue )
+    {
+        std::uint32_t resume = 0;
+        std::size_t lines = 0;
+
+        auto window = split( 0 );
+
+        while ( !window.empty() )
+        {
+            for ( auto& chunk : window )
+                chunk->worker.join();
+
+            // The next chunks are tokenized while the tokens of these are consumed
+            auto following = split( window.back()->end );
+
+            for ( auto& chunk : window )
+            {
+                if ( !stitch( *chunk, resume, lines, queue ) )
+                    return;
+
+                lines += chunk->newlines;
+            }
+
+            window = std::move( following );
+        }
+    }
+
+    std::vector< std::unique_ptr< chunked_lexer::chunk > > chunked_lexer::split( std::uint32_t begin )
+    {
+        std::vector< std::unique_ptr< chunk > > chunks;
+
+        while ( chunks.size() < jobs && begin < source.size() )
+        {
+            auto next = std::make_unique< chunk >();
+            next->begin = begin;
+
+            // Chunks end after a line, the last one at the end of the source
+            const auto newline = begin + chunk_size < source.size() ? source.find( '\n', begin + chunk_size )
+                                                                   : std::string_view::npos;
+
+            next->end = static_cast< std::uint32_t >( newline == std::string_view::npos ? source.size() : newline + 1 );
+            next->worker = std::thread( [ this, next = next.get() ]() { tokenize( *next ); } );
+
+            begin = next->end;
+            chunks.push_back( std::move( next ) );
+        }
+
+        return chunks;
+    }
+
+    void chunked_lexer::tokenize( chunk& chunk ) const
+    {
+        chunk.newlines = std::count( source.begin() + chunk.begin, source.begin() + chunk.end, '\n' );
+
+        lexer lexer( source, compiler, chunk.begin, 1 );
+
+        try
+        {
+            while ( true )
+            {
+                lexer.read_token();
+
+                if ( lexer.token_offset >= chunk.end )
+                {
+                    chunk.stop = std::move( lexer.t );
+                    chunk.stop_offset = lexer.token_offset;
+
+                    return;
+                }
+
+                chunk.tokens.emplace_back( std::move( lexer.t ), lexer.token_offset );
+            }
+        }
+        catch ( const utils::syntax_error& error )
+        {
+            chunk.error = error;
+        }
+    }
+
+    bool chunked_lexer::stitch( chunk& chunk, std::uint32_t& resume, std::size_t lines, token_queue& queue ) const
+    {
+        // The chunk is part of a token or comment that started in an earlier chunk
+        if ( resume >= chunk.end )
+            return true;
+
+        // The chunk agrees with the tokens before it if it has a token where they continue
+        const auto it = std::lower_bound(
+            chunk.tokens.begin(),
+            chunk.tokens.end(),
+            resume,
+            []( const auto& token, std::uint32_t offset ) { return token.second < offset; } );
+
+        const bool agrees = it != chunk.tokens.end() ? it->second == resume
+                                                     : !chunk.error && chunk.stop_offset == resume;
+
+        auto* tokens = &chunk;
+        auto first = static_cast< std::size_t >( it - chunk.tokens.begin() );
+
+        // Otherwise it started inside a token or comment, so it is tokenized again from where the tokens continue
+        struct chunk again;
+
+        if ( !agrees )
+        {
+            again.begin = resume;
+            again.end = chunk.end;
+            tokenize( again );
+
+            lines += std::count( source.begin() + chunk.begin, source.begin() + resume, '\n' );
+            tokens = &again;
+            first = 0;
+        }
+
+        for ( std::size_t i = first; i < tokens->tokens.size(); ++i )
+        {
+            auto& token = tokens->tokens[ i ].first;
+            shift( token.location, lines );
+
+            if ( !queue.push( std::move( token ) ) )
+                return false;
+        }
+
+        if ( tokens->error )
+        {
+            auto error = *tokens->error;
+            shift( error.location, lines );
+
+            queue.fail( std::make_exception_ptr( error ) );
+            return false;
+        }
+
+        resume = tokens->stop_offset;
+
+        if ( tokens->stop.type == token_type::eof )
+        {
+            shift( tokens->stop.location, lines );
+            queue.push( std::move( tokens->stop ) );
+
+            return false;
+        }
+
+        return true;
+    }
+}  // namespace lorraine::lexer
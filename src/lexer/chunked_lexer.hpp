@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../utils/error.hpp"
+#include "lexer.hpp"
+#include "token_queue.hpp"
+
+namespace lorraine::lexer
+{
+    /// @brief Tokenizes a large source on several threads. The source is split into chunks at line starts and every
+    /// chunk is tokenized on its own, assuming that no token or comment crosses into it. A chunk is only used if it
+    /// agrees with its predecessor: the token its predecessor ended before must be one of its tokens. Otherwise
+    /// (e.g. the chunk starts inside a long string or long comment) it is tokenized again from that token.
+    class chunked_lexer final
+    {
+       public:
+        /// @brief Creates a new chunked lexer
+        /// @param source The code to tokenize
+        /// @param compiler Main compiler instance
+        /// @param jobs Number of chunks tokenized at once
+        explicit chunked_lexer( const std::string_view& source, compiler::compiler* compiler, unsigned jobs );
+
+        /// @brief Tokenizes the source into a queue, in order. An error is handed to the queue in place of the token
+        /// that failed to tokenize.
+        /// @param queue The queue
+        void run( token_queue& queue );
+
+        /// @brief Size of a chunk, chunks end at the first line start after it
+        static constexpr std::size_t chunk_size = 1024 * 1024;
+
+       private:
+        struct chunk
+        {
+            /// @brief First offset of the chunk (a line start) and the offset after its last character
+            std::uint32_t begin = 0, end = 0;
+
+            /// @brief Tokens that start in the chunk, with the offset they start at
+            std::vector< std::pair< token, std::uint32_t > > tokens;
+
+            /// @brief The first token that starts at or after the end of the chunk, and its offset
+            token stop;
+            std::uint32_t stop_offset = 0;
+
+            /// @brief Error tokenizing the chunk failed with, nothing is tokenized after it
+            std::optional< utils::syntax_error > error;
+
+            /// @brief Lines that start in the chunk
+            std::size_t newlines = 0;
+
+            std::thread worker;
+
+            ~chunk();
+        };
+
+        std::string_view source;
+        compiler::compiler* compiler;
+        unsigned jobs;
+
+        /// @brief Splits the source after an offset into chunks for every job and starts tokenizing them
+        /// @param begin Offset of the first chunk (a line start)
+        /// @return The chunks, empty at the end of the source
+        std::vector< std::unique_ptr< chunk > > split( std::uint32_t begin );
+
+        /// @brief Tokenizes a chunk, starting at its beginning
+        /// @param chunk The chunk
+        void tokenize( chunk& chunk ) const;
+
+        /// @brief Moves the tokens of a chunk into the queue, after checking that the chunk agrees with the tokens
+        /// before it or tokenizing it again
+        /// @param chunk The chunk
+        /// @param resume Offset of the token that follows the tokens already queued, updated for the next chunk
+        /// @param lines Lines before the beginning of the chunk
+        /// @param queue The queue
+        /// @return False if nothing follows the chunk (end of file, error or the queue was closed)
+        bool stitch( chunk& chunk, std::uint32_t& resume, std::size_t lines, token_queue& queue ) const;
+    };
+}  // namespace lorraine::lexer
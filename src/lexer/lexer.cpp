@@ -1,14 +1,165 @@
 #include "lexer.hpp"
 
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <cwctype>
-#include <iomanip>
 #include <iostream>
 
+#include "chunked_lexer.hpp"
+
 namespace lorraine::lexer
 {
+    namespace
+    {
+        /// @brief Converts a number literal to its value, independent of the locale
+        /// @return The error the conversion failed with, if any
+        std::errc convert_number( std::string_view text, double& number, bool& integer )
+        {
+            const bool hex = text.size() > 1 && text[ 0 ] == '0' && ( text[ 1 ] == 'x' || text[ 1 ] == 'X' );
+
+            if ( hex )
+                text.remove_prefix( 2 );
+
+            // There is no sign after the prefix, from_chars would accept one
+            if ( text.empty() || text.front() == '-' || text.front() == '+' )
+                return std::errc::invalid_argument;
+
+            const char* end = text.data() + text.size();
+            const auto result =
+                std::from_chars( text.data(), end, number, hex ? std::chars_format::hex : std::chars_format::general );
+
+            if ( result.ec != std::errc{} )
+                return result.ec;
+
+            if ( result.ptr != end )
+                return std::errc::invalid_argument;
+
+            std::int64_t value;
+            integer = text.find_first_of( hex ? ".pP" : ".eE" ) == std::string_view::npos &&
+                      std::from_chars( text.data(), end, value, hex ? 16 : 10 ).ec == std::errc{};
+
+            return std::errc{};
+        }
+    }  // namespace
+
+    lexer::lexer( const std::string_view& source, compiler::compiler* compiler, bool pipelined )
+        : source( source ),
+          compiler( compiler )
+    {
+        if ( !pipelined )
+        {
+            next();
+            return;
+        }
+
+        queue = std::make_unique< token_queue >();
+
+        producer = std::thread(
+            [ this ]()
+            {
+                try
+                {
+                    const unsigned jobs = std::thread::hardware_concurrency();
+
+                    // Huge sources can also be split up between several threads
+                    if ( this->compiler && this->compiler->cfg.get< bool >( "parallelLexing" ) && jobs > 2 &&
+                         this->source.size() >= 2 * chunked_lexer::chunk_size )
+                    {
+                        chunked_lexer lexer( this->source, this->compiler, jobs - 1 );
+                        lexer.run( *queue );
+
+                        return;
+                    }
+
+                    lexer lexer( this->source, this->compiler );
+
+                    while ( queue->push( token{ lexer.current() } ) && lexer.current().type != token_type::eof )
+                        lexer.next();
+                }
+                catch ( ... )
+                {
+                    // Handed to the consumer in place of the token that failed to tokenize
+                    queue->fail( std::current_exception() );
+                }
+            } );
+
+        try
+        {
+            t = queue->take();
+        }
+        catch ( ... )
+        {
+            // The destructor does not run for a lexer that failed to construct, the producer is stopped here
+            queue->close();
+            producer.join();
+
+            throw;
+        }
+    }
+
+    lexer::lexer(
+        const std::string_view& source,
+        compiler::compiler* compiler,
+        std::uint32_t start,
+        std::uint32_t start_line )
+        : source( source ),
+          compiler( compiler ),
+          line( start_line ),
+          offset( start )
+    {
+        const auto newline = start > 0 ? source.rfind( '\n', start - 1 ) : std::string_view::npos;
+        line_offset = newline == std::string_view::npos ? 0 : static_cast< std::uint32_t >( newline + 1 );
+    }
+
+    lexer::~lexer()
+    {
+        if ( producer.joinable() )
+        {
+            queue->close();
+            producer.join();
+        }
+    }
+
     void lexer::next()
     {
+        if ( tokens )
+        {
+            if ( t.type != token_type::eof )
+                t = replay( ++position );
+        }
+        else if ( !queue )
+            read_token();
+        // Like the lexer itself, the end of file is repeated once it was reached
+        else if ( t.type != token_type::eof )
+            t = queue->take();
+    }
+
+    const token& lexer::replay( std::size_t index )
+    {
+        if ( index >= tokens->size() )
+        {
+            // Tokens that stopped at an error end with it instead of the end of file
+            if ( tokens->empty() || tokens->back().type != token_type::eof )
+                throw *error;
+
+            index = tokens->size() - 1;
+        }
+
+        furthest = std::max( furthest, index );
+
+        return ( *tokens )[ index ];
+    }
+
+    void lexer::read_token()
+    {
+        token_offset = offset;
+
         consume_space_or_comment();
+        token_offset = offset;
         const utils::position start = current_position();
 
         switch ( char c = peek_character() )
@@ -162,12 +313,9 @@ namespace lorraine::lexer
                 t.location = { start, start };
                 break;
             case '-':
-                if ( std::isdigit( peek_character( 1 ) ) )
-                {
-                    read_number( start );
-                    break;
-                }
+                consume_character();
 
+                // Negative numbers are negated literals, so that '-' is also an operator after a value
                 if ( peek_character() == '-' )
                 {
                     consume_character();
@@ -178,7 +326,7 @@ namespace lorraine::lexer
                 else if ( peek_character() == '=' )
                 {
                     consume_character();
-                    t.type = token_type::cmb_compme;
+                    t.type = token_type::cmb_compse;
                     t.location = { start, current_position() };
                     break;
                 }
@@ -267,6 +415,20 @@ namespace lorraine::lexer
 
     token lexer::peek( std::size_t count )
     {
+        if ( tokens )
+            return replay( position + count );
+
+        if ( queue )
+        {
+            token peeked = t;
+
+            // Nothing is produced after the end of file
+            for ( std::size_t i = 0; i < count && peeked.type != token_type::eof; ++i )
+                peeked = queue->peek( i );
+
+            return peeked;
+        }
+
         // Save the old offsets as we will reset them later
         const std::size_t old_offset = offset, old_line = line, old_line_offset = line_offset;
         const token old_token = current();
@@ -428,26 +590,40 @@ namespace lorraine::lexer
     void lexer::read_number( const utils::position& start )
     {
         const std::size_t start_offset = offset;
-        consume_character();
+        const bool hex = peek_character() == '0' && ( peek_character( 1 ) == 'x' || peek_character( 1 ) == 'X' );
 
-        while ( std::isdigit( peek_character() ) || peek_character() == '.' )
+        if ( hex )
+        {
+            consume_character();
             consume_character();
+        }
+
+        const char exponent = hex ? 'p' : 'e';
 
-        if ( peek_character() == 'e' || peek_character() == 'E' )
+        // Like in Lua, everything that could belong to the number is read, it has to be a valid number as a whole
+        while ( true )
         {
-            consume_character();
+            const char c = peek_character();
 
-            if ( peek_character() == '+' || peek_character() == '-' )
+            if ( std::tolower( c ) == exponent && ( peek_character( 1 ) == '+' || peek_character( 1 ) == '-' ) )
                 consume_character();
-        }
+            else if ( !std::isalnum( c ) && c != '.' && c != '_' )
+                break;
 
-        // Added for hexadecimal support, simplifies work in the parser
-        while ( std::isdigit( peek_character() ) || std::isalpha( peek_character() ) )
             consume_character();
+        }
 
         t.location = { start, current_position() };
         t.type = token_type::number;
         t.value = source.substr( start_offset, offset - start_offset );
+
+        switch ( convert_number( t.value, t.number, t.integer ) )
+        {
+            case std::errc{}: break;
+            case std::errc::result_out_of_range:
+                throw utils::syntax_error( t.location, "number out of range near '" + t.value + "'" );
+            default: throw utils::syntax_error( t.location, "malformed number near '" + t.value + "'" );
+        }
     }
 
     const bool lexer::read_long_string( const utils::position& start )
@@ -493,22 +669,21 @@ namespace lorraine::lexer
         return delims;
     }
 
-    std::stringstream lexer::print_tokens()
+    void lexer::print_tokens( llvm::raw_ostream& out )
     {
-        std::stringstream out;
         token token;
 
         do
         {
             token = current();
 
-            out << std::left << std::setw( 15 ) << token.to_string() << std::right << std::setw( 12 )
-                << token.location.start.line << ':' << token.location.start.column << "-" << token.location.end.line
-                << ':' << token.location.end.column << '\n';
+            const auto& [ start, end ] = token.location;
+
+            out << llvm::left_justify( token.to_string(), 15 )
+                << llvm::format_decimal( static_cast< std::int64_t >( start.line ), 12 ) << ':' << start.column << '-'
+                << end.line << ':' << end.column << '\n';
 
             next();
         } while ( token.type != token_type::eof );
-
-        return out;
     }
 }  // namespace lorraine::lexer
\ No newline at end of file
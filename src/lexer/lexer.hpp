@@ -1,10 +1,20 @@
 #pragma once
 
 #include <clocale>
+#include <memory>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "../compiler/compiler.hpp"
+#include "../utils/error.hpp"
 #include "token.hpp"
+#include "token_queue.hpp"
+
+namespace lorraine::parser
+{
+    class document;
+}
 
 namespace lorraine::lexer
 {
@@ -21,6 +31,37 @@ namespace lorraine::lexer
             next();
         }
 
+        /// @brief Constructs a new lexer instance that tokenizes the source on a thread of its own, ahead of the
+        /// tokens being consumed. Only worth it for large sources (see pipeline_threshold).
+        /// @param source The code to tokenize
+        /// @param compiler Main compiler instance
+        /// @param pipelined Tokenize on a separate thread
+        explicit lexer( const std::string_view& source, compiler::compiler* compiler, bool pipelined );
+
+        /// @brief Constructs a new lexer instance that replays tokens that were already tokenized
+        /// @param tokens The tokens, ending with the end of file or with the error tokenizing failed with
+        /// @param position Position of the first token
+        /// @param compiler Main compiler instance
+        /// @param error The error if tokenizing failed, it is thrown once the lexer reaches it
+        explicit lexer(
+            const std::vector< token >& tokens,
+            std::size_t position,
+            compiler::compiler* compiler,
+            const utils::syntax_error* error = nullptr )
+            : compiler( compiler ),
+              tokens( &tokens ),
+              error( error ),
+              position( position ),
+              furthest( position )
+        {
+            t = replay( position );
+        }
+
+        ~lexer();
+
+        /// @brief Size from which sources are tokenized on a separate thread by the parser
+        static constexpr std::size_t pipeline_threshold = 256 * 1024;
+
         /// @brief Gets the current token (last set by 'next')
         /// @return The last token tokenized
         const token& current() const
@@ -36,16 +77,62 @@ namespace lorraine::lexer
         /// @return Next token
         token peek( std::size_t count = 1 );
 
-        /// @brief Dumps all tokens to the console
-        /// @returns The output stream the tokens will be sent to
-        std::stringstream print_tokens();
+        /// @brief Gets the position of the current token in the replayed tokens
+        std::size_t get_position() const
+        {
+            return position;
+        }
+
+        /// @brief Gets the position of the last replayed token that was looked at, including peeked tokens
+        std::size_t get_furthest_position() const
+        {
+            return furthest;
+        }
+
+        /// @brief Dumps all tokens, one per line
+        /// @param out The stream the tokens are written to
+        void print_tokens( llvm::raw_ostream& out );
 
        private:
+        friend class chunked_lexer;
+        friend class parser::document;
+
+        /// @brief Constructs a new lexer instance that starts at an offset of the source, without tokenizing anything
+        /// @param source The code to tokenize
+        /// @param compiler Main compiler instance
+        /// @param start Offset to start at
+        /// @param start_line Line number of the line the offset is in
+        explicit lexer(
+            const std::string_view& source,
+            compiler::compiler* compiler,
+            std::uint32_t start,
+            std::uint32_t start_line );
+
         std::string_view source{};
         compiler::compiler* compiler;
 
         token t;
 
+        /// @brief Offset of the current token in the source
+        std::uint32_t token_offset = 0;
+
+        /// @brief Tokens produced by the lexer thread, if the lexer is pipelined
+        std::unique_ptr< token_queue > queue;
+        std::thread producer;
+
+        /// @brief Tokens that are replayed instead of tokenizing the source, if set
+        const std::vector< token >* tokens = nullptr;
+        const utils::syntax_error* error = nullptr;
+        std::size_t position = 0, furthest = 0;
+
+        /// @brief Gets a replayed token, the end of file is repeated once it was reached
+        /// @param index Position of the token
+        /// @return The token
+        const token& replay( std::size_t index );
+
+        /// @brief Tokenizes the next token of the source (see next)
+        void read_token();
+
         std::uint32_t line = 1;
         std::uint32_t offset = 0;
         std::uint32_t line_offset = 0;
@@ -86,6 +173,7 @@ namespace lorraine::lexer
             { "local", token_type::kw_local },
             { "nil", token_type::kw_nil },
             { "not", token_type::kw_not },
+            { "or", token_type::kw_or },
             { "repeat", token_type::kw_repeat },
             { "return", token_type::kw_return },
             { "then", token_type::kw_then },
@@ -107,7 +195,7 @@ namespace lorraine::lexer
             { '?', token_type::sym_question }, { '{', token_type::sym_lbrace }, { '}', token_type::sym_rbrace },
             { ':', token_type::sym_colon },    { ',', token_type::sym_comma },  { '(', token_type::sym_lparen },
             { ')', token_type::sym_rparen },   { '|', token_type::sym_pipe },   { '[', token_type::sym_lbracket },
-            { ']', token_type::sym_rbracket }
+            { ']', token_type::sym_rbracket }, { '%', token_type::sym_mod },    { '#', token_type::sym_len }
         };
     };
 }  // namespace lorraine::lexer
\ No newline at end of file
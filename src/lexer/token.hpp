@@ -99,6 +99,11 @@ namespace lorraine::lexer
         std::string value{};  
         utils::location location{};
 
+        /// @brief Value of a number token, and if it is an integer: written without a fraction or an exponent and in
+        /// the range of a 64-bit integer
+        double number = 0;
+        bool integer = false;
+
         /// @brief Returns a string representation of the token type provided
         /// @param type Token type
         /// @return String representation
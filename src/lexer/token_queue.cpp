@@ -0,0 +1,80 @@
+#include "token_queue.hpp"
+
+#include <thread>
+
+namespace lorraine::lexer
+{
+    bool token_queue::push( token&& token )
+    {
+        const std::size_t position = tail.load( std::memory_order_relaxed );
+
+        if ( !reserve( position ) )
+            return false;
+
+        elements[ position % capacity ] = element{ std::move( token ), nullptr };
+        tail.store( position + 1, std::memory_order_release );
+
+        return !closed.load( std::memory_order_relaxed );
+    }
+
+    void token_queue::fail( std::exception_ptr error )
+    {
+        const std::size_t position = tail.load( std::memory_order_relaxed );
+
+        if ( !reserve( position ) )
+            return;
+
+        elements[ position % capacity ] = element{ token{}, std::move( error ) };
+        tail.store( position + 1, std::memory_order_release );
+    }
+
+    token token_queue::take()
+    {
+        const std::size_t position = head.load( std::memory_order_relaxed );
+        auto& next = wait( position );
+
+        if ( next.error )
+            std::rethrow_exception( next.error );
+
+        token result = std::move( next.value );
+        head.store( position + 1, std::memory_order_release );
+
+        return result;
+    }
+
+    const token& token_queue::peek( std::size_t offset )
+    {
+        auto& next = wait( head.load( std::memory_order_relaxed ) + offset );
+
+        if ( next.error )
+            std::rethrow_exception( next.error );
+
+        return next.value;
+    }
+
+    void token_queue::close()
+    {
+        closed.store( true, std::memory_order_relaxed );
+    }
+
+    bool token_queue::reserve( std::size_t position ) const
+    {
+        while ( position - head.load( std::memory_order_acquire ) == capacity )
+        {
+            if ( closed.load( std::memory_order_relaxed ) )
+                return false;
+
+            std::this_thread::yield();
+        }
+
+        return true;
+    }
+
+    token_queue::element& token_queue::wait( std::size_t position )
+    {
+        while ( tail.load( std::memory_order_acquire ) <= position )
+            std::this_thread::yield();
+
+        return elements[ position % capacity ];
+    }
+}  // namespace lorraine::lexer
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+
+#include "token.hpp"
+
+namespace lorraine::lexer
+{
+    /// @brief Bounded lock-free ring of tokens between exactly one producer thread (the lexer) and one consumer
+    /// thread (the parser). Both sides wait by spinning, as the other side is expected to catch up quickly.
+    class token_queue final
+    {
+       public:
+        /// @brief Number of tokens the producer can be ahead of the consumer
+        static constexpr std::size_t capacity = 1024;
+
+        /// @brief Appends a token, waits while the queue is full (producer only)
+        /// @param token The token
+        /// @return False if the consumer closed the queue, the producer should stop
+        bool push( token&& token );
+
+        /// @brief Ends the queue with an error instead of a token (producer only). The consumer receives the error
+        /// once it reaches it, in the same place the token it stands for would have been.
+        /// @param error The error
+        void fail( std::exception_ptr error );
+
+        /// @brief Removes the first token, waits until there is one (consumer only). Rethrows the error the producer
+        /// failed with if there are no tokens before it.
+        /// @return The token
+        token take();
+
+        /// @brief Gets a token without removing it, waits until it is available (consumer only)
+        /// @param offset Position of the token after the first one, less than the capacity
+        /// @return The token
+        const token& peek( std::size_t offset = 0 );
+
+        /// @brief Stops the producer, it is no longer waited for (consumer only)
+        void close();
+
+       private:
+        /// @brief A token or the error the producer failed with instead of producing it
+        struct element
+        {
+            token value;
+            std::exception_ptr error;
+        };
+
+        std::array< element, capacity > elements;
+
+        /// @brief Position of the first token, only written by the consumer
+        alignas( 64 ) std::atomic< std::size_t > head = 0;
+
+        /// @brief Position after the last token, only written by the producer
+        alignas( 64 ) std::atomic< std::size_t > tail = 0;
+
+        std::atomic< bool > closed = false;
+
+        /// @brief Waits until there is room for another element
+        /// @param position The position the element will be written to
+        /// @return False if the consumer closed the queue
+        bool reserve( std::size_t position ) const;
+
+        /// @brief Waits until an element was produced
+        /// @param position The position of the element
+        /// @return The element
+        element& wait( std::size_t position );
+    };
+}  // namespace lorraine::lexer
@@ -0,0 +1,24 @@
+#include <llvm/Support/WithColor.h>
+
+#include "cli/cli.hpp"
+#include "daemon/client.hpp"
+#include "utils/error.hpp"
+
+int main( int argc, char* argv[] )
+{
+    // Forwarded command lines are compiled by the daemon, this process only waits for the result
+    if ( const auto code = lorraine::daemon::client::forward( argc, argv ) )
+        return *code;
+
+    try
+    {
+        lorraine::cli::cli cli{ argc, argv };
+
+        return cli.parse();
+    }
+    catch ( const lorraine::utils::compiler_error& e )
+    {
+        llvm::WithColor::error() << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,378 @@
+#include "document.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "../ast/visitor.hpp"
+#include "../cache/interface.hpp"
+
+namespace lorraine::parser
+{
+    namespace
+    {
+        /// @brief Moves a location down by a number of lines
+        void shift( utils::location& location, std::ptrdiff_t lines )
+        {
+            location.start.line += lines;
+            location.end.line += lines;
+        }
+
+        /// @brief Moves a statement and everything in it down by a number of lines
+        struct line_shifter final : ast::visitor
+        {
+            using ast::visitor::visit;
+
+            std::ptrdiff_t lines;
+
+            explicit line_shifter( std::ptrdiff_t lines ) : lines( lines )
+            {
+            }
+
+            bool visit( ast::node* node ) override
+            {
+                shift( node->location, lines );
+
+                // Not part of the visitor, assignments are visited as expressions
+                if ( auto assignment = dynamic_cast< ast::variable_assignment* >( node ) )
+                    shift( assignment->var->location, lines );
+
+                return true;
+            }
+
+            bool visit( ast::variable_reference* node ) override
+            {
+                shift( node->var->location, lines );
+                return visit( static_cast< ast::node* >( node ) );
+            }
+
+            bool visit( ast::function_prototype* node ) override
+            {
+                for ( const auto& argument : node->args )
+                    shift( argument->location, lines );
+
+                return visit( static_cast< ast::node* >( node ) );
+            }
+
+            bool visit( ast::local_assignment* node ) override
+            {
+                for ( const auto& variable : node->variables )
+                    shift( variable->location, lines );
+
+                return visit( static_cast< ast::node* >( node ) );
+            }
+
+            bool visit( ast::external_decleration* node ) override
+            {
+                shift( node->var->location, lines );
+                return visit( static_cast< ast::node* >( node ) );
+            }
+
+            // Imported modules are located in their own source
+            bool visit( ast::module* node ) override
+            {
+                return false;
+            }
+        };
+
+        /// @brief Replaces a range of a list, moving the elements after it only once (if at all)
+        /// @param list The list
+        /// @param begin First element of the range
+        /// @param end Element after the range
+        /// @param elements The new elements
+        template< typename T >
+        void splice( std::vector< T >& list, std::size_t begin, std::size_t end, std::vector< T >&& elements )
+        {
+            const std::size_t common = std::min( end - begin, elements.size() );
+
+            std::move( elements.begin(), elements.begin() + common, list.begin() + begin );
+
+            if ( common < elements.size() )
+                list.insert(
+                    list.begin() + end,
+                    std::make_move_iterator( elements.begin() + common ),
+                    std::make_move_iterator( elements.end() ) );
+            else
+                list.erase( list.begin() + begin + common, list.begin() + end );
+        }
+
+        /// @brief Checks if two lists of declarations declare the same names with the same types, in the same order
+        bool is_same( const std::vector< declaration >& a, const std::vector< declaration >& b )
+        {
+            return std::equal(
+                a.begin(),
+                a.end(),
+                b.begin(),
+                b.end(),
+                []( const declaration& a, const declaration& b )
+                {
+                    return a.kind == b.kind && a.name == b.name &&
+                           ( a.type == b.type || cache::describe( *a.type ) == cache::describe( *b.type ) );
+                } );
+        }
+    }  // namespace
+
+    std::unique_ptr< document > document::open(
+        const std::string& name,
+        std::string source,
+        compiler::compiler* compiler )
+    {
+        std::unique_ptr< document > result( new document( compiler ) );
+
+        result->info = ast::module::information::get( name, {} );
+        result->info->buffer = std::move( source );
+        result->info->source = result->info->buffer;
+
+        // The scope of the module is created once, before there are any tokens
+        const std::vector< lexer::token > none( 1 );
+        parser parser( result->info, none, 0, compiler );
+
+        try
+        {
+            result->module = std::make_unique< ast::module >( result->info, parser.create_block() );
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            compiler->llvm_display_error( result->info->absolute(), result->info->source, e );
+            return nullptr;
+        }
+
+        result->builtins = result->module->body->types;
+        result->update( 0, 0, result->info->buffer.size() );
+
+        return result;
+    }
+
+    bool document::apply( const std::vector< text_edit >& edits )
+    {
+        auto& source = info->buffer;
+
+        // The edits are merged into one that replaces everything between the first and the last changed character
+        const std::size_t old_size = source.size();
+        std::size_t begin = old_size, suffix = old_size;
+
+        for ( const auto& edit : edits )
+        {
+            if ( edit.offset > source.size() || edit.length > source.size() - edit.offset )
+                throw utils::compiler_error( "edit out of range of the source of '" + info->absolute() + "'" );
+
+            begin = std::min( begin, edit.offset );
+            suffix = std::min( suffix, source.size() - edit.offset - edit.length );
+
+            source.replace( edit.offset, edit.length, edit.text );
+        }
+
+        info->source = source;
+
+        if ( edits.empty() )
+            return complete;
+
+        return update( begin, old_size - suffix, source.size() - suffix );
+    }
+
+    std::vector< ast::statement* > document::get_parsed() const
+    {
+        std::vector< ast::statement* > parsed;
+
+        for ( std::size_t i = parsed_first; i < parsed_first + parsed_count; ++i )
+            parsed.push_back( module->body->body[ i ].get() );
+
+        return parsed;
+    }
+
+    bool document::update( std::size_t begin, std::size_t old_end, std::size_t new_end )
+    {
+        const std::string_view source = info->source;
+        const auto delta = static_cast< std::ptrdiff_t >( new_end ) - static_cast< std::ptrdiff_t >( old_end );
+
+        // The token before the edit is tokenized again as well, as the edit may continue it (or start a comment)
+        std::size_t first = std::lower_bound( offsets.begin(), offsets.end(), begin ) - offsets.begin();
+        first = first > 0 ? first - 1 : 0;
+
+        const bool starts_at_token = first < offsets.size() && offsets[ first ] <= begin;
+        const std::uint32_t start = starts_at_token ? offsets[ first ] : 0;
+        const std::size_t start_line = starts_at_token ? tokens[ first ].location.start.line : 1;
+
+        // Old tokens are kept from the first new token that starts where an old one started, on a line after the
+        // edit (so that only their lines change). There are none to keep after an error.
+        const auto newline = !error ? source.find( '\n', new_end ) : std::string_view::npos;
+
+        std::vector< lexer::token > fresh;
+        std::vector< std::uint32_t > fresh_offsets;
+
+        std::size_t resume = tokens.size();
+        std::ptrdiff_t lines = 0;
+
+        lexer::lexer lexer( source, compiler, start, static_cast< std::uint32_t >( start_line ) );
+
+        error.reset();
+
+        try
+        {
+            do
+            {
+                lexer.read_token();
+
+                if ( newline != std::string_view::npos && lexer.token_offset > newline )
+                {
+                    const auto old_offset = static_cast< std::uint32_t >( lexer.token_offset - delta );
+                    const auto it = std::lower_bound( offsets.begin() + first, offsets.end(), old_offset );
+
+                    if ( it != offsets.end() && *it == old_offset )
+                    {
+                        resume = it - offsets.begin();
+                        lines = static_cast< std::ptrdiff_t >( lexer.t.location.start.line ) -
+                                static_cast< std::ptrdiff_t >( tokens[ resume ].location.start.line );
+                        break;
+                    }
+                }
+
+                fresh_offsets.push_back( lexer.token_offset );
+                fresh.push_back( std::move( lexer.t ) );
+            } while ( fresh.back().type != lexer::token_type::eof );
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            // Like with a lexer of its own, the parser only fails with it once it reaches it
+            error = e;
+        }
+
+        // The tokens that are kept moved with the edit
+        for ( std::size_t i = resume; i < tokens.size() && ( delta != 0 || lines != 0 ); ++i )
+        {
+            offsets[ i ] += delta;
+            shift( tokens[ i ].location, lines );
+        }
+
+        const std::size_t added = fresh.size();
+
+        splice( tokens, first, resume, std::move( fresh ) );
+        splice( offsets, first, resume, std::move( fresh_offsets ) );
+
+        return reparse( first, resume, added, lines );
+    }
+
+    bool document::reparse( std::size_t first, std::size_t resume, std::size_t added, std::ptrdiff_t lines )
+    {
+        auto& body = module->body->body;
+
+        // Statements that did not look at any of the new tokens are kept as they are
+        std::size_t kept = 0;
+
+        while ( kept < entries.size() && entries[ kept ].furthest < first )
+            ++kept;
+
+        // Statements after the new tokens only moved, they are kept if the scope they are parsed in stays the same.
+        // Nothing after a syntax error was parsed, so parsing has to continue up to the end after one anyway.
+        std::size_t following = kept;
+        std::vector< declaration > replaced;
+
+        for ( ; following < entries.size() && ( !complete || entries[ following ].first < resume ); ++following )
+        {
+            const auto& declarations = entries[ following ].declarations;
+            replaced.insert( replaced.end(), declarations.begin(), declarations.end() );
+        }
+
+        const auto moved = static_cast< std::ptrdiff_t >( added ) - static_cast< std::ptrdiff_t >( resume - first );
+        line_shifter shifter( lines );
+
+        for ( std::size_t i = following; i < entries.size(); ++i )
+        {
+            entries[ i ].first += moved;
+            entries[ i ].end += moved;
+            entries[ i ].furthest += moved;
+
+            if ( lines != 0 )
+                body[ i ]->visit( &shifter );
+        }
+
+        ast::statement_list candidates(
+            std::make_move_iterator( body.begin() + following ), std::make_move_iterator( body.end() ) );
+        std::vector< entry > candidate_entries(
+            std::make_move_iterator( entries.begin() + following ), std::make_move_iterator( entries.end() ) );
+
+        body.resize( kept );
+        entries.resize( kept );
+
+        // The scope is rebuilt from the declarations of the statements that are kept
+        auto* root = module->body.get();
+
+        root->variables.clear();
+        root->types = builtins;
+        root->export_variables.clear();
+        root->export_types.clear();
+
+        for ( const auto& statement : entries )
+        {
+            for ( const auto& declaration : statement.declarations )
+                declaration.apply( root );
+        }
+
+        if ( !tokens.empty() )
+        {
+            root->location = tokens.front().location;
+            module->location = root->location;
+        }
+
+        std::vector< declaration > declared;
+        std::size_t next = 0;
+
+        parsed_first = kept;
+        parsed_count = 0;
+
+        try
+        {
+            parser parser( info, tokens, kept > 0 ? entries[ kept - 1 ].end : 0, compiler, error ? &*error : nullptr );
+            parser.last_block = root;
+
+            while ( parser.lexer.current().type != lexer::token_type::eof )
+            {
+                const std::size_t position = parser.lexer.get_position();
+
+                // Statements that overlap the parsed ones are replaced by them
+                for ( ; next < candidates.size() && candidate_entries[ next ].first < position; ++next )
+                    replaced.insert(
+                        replaced.end(),
+                        candidate_entries[ next ].declarations.begin(),
+                        candidate_entries[ next ].declarations.end() );
+
+                if ( next < candidates.size() && candidate_entries[ next ].first == position &&
+                     is_same( declared, replaced ) )
+                {
+                    for ( ; next < candidates.size(); ++next )
+                    {
+                        for ( const auto& declaration : candidate_entries[ next ].declarations )
+                            declaration.apply( root );
+
+                        body.push_back( std::move( candidates[ next ] ) );
+                        entries.push_back( std::move( candidate_entries[ next ] ) );
+                    }
+
+                    break;
+                }
+
+                entry parsed;
+                parsed.first = position;
+                parser.journal = &parsed.declarations;
+
+                body.push_back( parser.parse_statement() );
+
+                parsed.end = parser.lexer.get_position();
+                parsed.furthest = parser.lexer.get_furthest_position();
+
+                declared.insert( declared.end(), parsed.declarations.begin(), parsed.declarations.end() );
+                entries.push_back( std::move( parsed ) );
+                ++parsed_count;
+            }
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            compiler->llvm_display_error( info->absolute(), info->source, e );
+
+            complete = false;
+            return false;
+        }
+
+        complete = true;
+        return true;
+    }
+}  // namespace lorraine::parser
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace lorraine::parser
+{
+    /// @brief Replaces a range of a source with new text
+    struct text_edit
+    {
+        /// @brief Offset and length of the replaced range in the source the edit is applied to
+        std::size_t offset = 0, length = 0;
+        std::string text;
+    };
+
+    /// @brief A module that stays parsed while its source is edited (e.g. by an editor). An edit only tokenizes the
+    /// source again up to the first token that starts where an old token started, on a line after the edit. Only the
+    /// top-level statements that looked at one of the new tokens are parsed again, all other statements are kept.
+    ///
+    /// The statements after the parsed ones are only kept if the parsed statements declare the same names as the
+    /// statements they replace, as they may refer to them. Otherwise parsing continues up to the next statement for
+    /// which this holds.
+    class document final
+    {
+       public:
+        /// @brief Tokenizes and parses a new document. Syntax errors are reported, the statements before them are
+        /// parsed anyway (see is_complete).
+        /// @param name Path of the module
+        /// @param source The code
+        /// @param compiler Main compiler instance
+        /// @return The document or nullptr if the scope of the module could not be created
+        static std::unique_ptr< document > open(
+            const std::string& name,
+            std::string source,
+            compiler::compiler* compiler );
+
+        /// @brief Applies edits to the source and updates the tokens and the syntax tree. Syntax errors are reported.
+        /// Statements that were parsed again are not validated (see get_parsed).
+        /// @param edits Edits applied one after another, each to the source the edit before it produced
+        /// @return False if a syntax error was reported, the module only has the statements before the error then
+        bool apply( const std::vector< text_edit >& edits );
+
+        /// @brief Checks if all of the source was parsed, as it is not after a syntax error
+        bool is_complete() const
+        {
+            return complete;
+        }
+
+        const std::string& get_source() const
+        {
+            return info->buffer;
+        }
+
+        const std::vector< lexer::token >& get_tokens() const
+        {
+            return tokens;
+        }
+
+        ast::module& get_module() const
+        {
+            return *module;
+        }
+
+        /// @brief Gets the top-level statements that were parsed by the last update, all other statements were kept
+        /// @return The statements, in order
+        std::vector< ast::statement* > get_parsed() const;
+
+       private:
+        /// @brief What is known about a top-level statement of the module
+        struct entry
+        {
+            /// @brief Position of its first token and of the token after it
+            std::size_t first = 0, end = 0;
+
+            /// @brief Position of the last token the parser looked at (at least `end`, for the lookahead)
+            std::size_t furthest = 0;
+
+            /// @brief Names it declared in the scope of the module
+            std::vector< declaration > declarations;
+        };
+
+        compiler::compiler* compiler;
+
+        /// @brief Owns the source (see ast::module::information::buffer)
+        std::shared_ptr< ast::module::information > info;
+
+        /// @brief Tokens and the offsets they start at. If tokenizing failed, the tokens end before the error instead
+        /// of with the end of file.
+        std::vector< lexer::token > tokens;
+        std::vector< std::uint32_t > offsets;
+        std::optional< utils::syntax_error > error;
+
+        /// @brief The module and its statements, one entry for every statement of its body
+        std::unique_ptr< ast::module > module;
+        std::vector< entry > entries;
+
+        /// @brief The types every module has, the scope of the module is reset to them before it is parsed again
+        std::unordered_map< std::string, std::shared_ptr< ast::type::type > > builtins;
+
+        /// @brief First statement and number of statements the last update parsed
+        std::size_t parsed_first = 0, parsed_count = 0;
+
+        bool complete = false;
+
+        explicit document( compiler::compiler* compiler ) : compiler( compiler )
+        {
+        }
+
+        /// @brief Updates the tokens and the statements after a range of the source was replaced
+        /// @param begin Offset of the replaced range
+        /// @param old_end Offset after the replaced range, before it was replaced
+        /// @param new_end Offset after the replaced range, as it is now
+        /// @return False if a syntax error was reported
+        bool update( std::size_t begin, std::size_t old_end, std::size_t new_end );
+
+        /// @brief Parses the statements that looked at new tokens again
+        /// @param first Position of the first new token
+        /// @param resume Position (before the new tokens replaced the old ones) of the first old token that was kept
+        /// @param added Number of new tokens
+        /// @param lines Number of lines the kept tokens moved down by
+        /// @return False if a syntax error was reported
+        bool reparse( std::size_t first, std::size_t resume, std::size_t added, std::ptrdiff_t lines );
+    };
+}  // namespace lorraine::parser
@@ -1,11 +1,86 @@
 #include "parser.hpp"
 
 #include <charconv>
+#include <optional>
 
 #include "../utils/utils.hpp"
 
 namespace lorraine::parser
 {
+    namespace
+    {
+        /// @brief Priorities of a binary operator on its left and right side, the same as Lua's. Operators with a
+        /// higher priority on the right than on the left are right associative.
+        struct priority
+        {
+            unsigned left, right;
+        };
+
+        /// @brief Priority of unary operators, only '^' binds tighter
+        constexpr unsigned unary_priority = 12;
+
+        std::optional< ast::binary_operator > get_binary_operator( lexer::token_type type )
+        {
+            switch ( type )
+            {
+                case lexer::token_type::sym_plus: return ast::binary_operator::add;
+                case lexer::token_type::sym_min: return ast::binary_operator::subtract;
+                case lexer::token_type::sym_mul: return ast::binary_operator::multiply;
+                case lexer::token_type::sym_div: return ast::binary_operator::divide;
+                case lexer::token_type::sym_mod: return ast::binary_operator::modulo;
+                case lexer::token_type::sym_pow: return ast::binary_operator::power;
+                case lexer::token_type::cmb_concat: return ast::binary_operator::concat;
+                case lexer::token_type::cmb_eq: return ast::binary_operator::equal;
+                case lexer::token_type::cmb_ne: return ast::binary_operator::not_equal;
+                case lexer::token_type::sym_l: return ast::binary_operator::less;
+                case lexer::token_type::cmb_le: return ast::binary_operator::less_equal;
+                case lexer::token_type::sym_g: return ast::binary_operator::greater;
+                case lexer::token_type::cmb_ge: return ast::binary_operator::greater_equal;
+                case lexer::token_type::kw_and: return ast::binary_operator::logical_and;
+                case lexer::token_type::kw_or: return ast::binary_operator::logical_or;
+                default: return std::nullopt;
+            }
+        }
+
+        std::optional< ast::unary_operator > get_unary_operator( lexer::token_type type )
+        {
+            switch ( type )
+            {
+                case lexer::token_type::sym_min: return ast::unary_operator::negate;
+                case lexer::token_type::kw_not: return ast::unary_operator::logical_not;
+                case lexer::token_type::sym_len: return ast::unary_operator::length;
+                default: return std::nullopt;
+            }
+        }
+
+        priority get_priority( ast::binary_operator op )
+        {
+            switch ( op )
+            {
+                case ast::binary_operator::add:
+                case ast::binary_operator::subtract: return { 10, 10 };
+                case ast::binary_operator::multiply:
+                case ast::binary_operator::divide:
+                case ast::binary_operator::modulo: return { 11, 11 };
+                case ast::binary_operator::power: return { 14, 13 };
+                case ast::binary_operator::concat: return { 9, 8 };
+                case ast::binary_operator::logical_and: return { 2, 2 };
+                case ast::binary_operator::logical_or: return { 1, 1 };
+                default: return { 3, 3 };
+            }
+        }
+    }  // namespace
+
+    void declaration::apply( ast::block* block ) const
+    {
+        switch ( kind )
+        {
+            case declaration_kind::variable: block->variables.emplace( name, type ); break;
+            case declaration_kind::type: block->types.emplace( name, type ); break;
+            case declaration_kind::export_type: block->export_types.emplace( name, type ); break;
+        }
+    }
+
     std::unique_ptr< ast::module > parser::parse()
     {
         std::unique_ptr< ast::block > root = nullptr;
@@ -25,7 +100,46 @@ namespace lorraine::parser
         }
     }
 
+    std::unique_ptr< ast::module > parser::parse_module_scope()
+    {
+        try
+        {
+            return std::make_unique< ast::module >( info, create_block() );
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            compiler->llvm_display_error( info->absolute(), source, e );
+            return nullptr;
+        }
+    }
+
+    bool parser::parse_next( std::unique_ptr< ast::statement >& statement )
+    {
+        try
+        {
+            statement = lexer.current().type != lexer::token_type::eof ? parse_statement() : nullptr;
+
+            return true;
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            compiler->llvm_display_error( info->absolute(), source, e );
+            return false;
+        }
+    }
+
     std::unique_ptr< ast::block > parser::parse_block()
+    {
+        std::unique_ptr< ast::block > block = create_block();
+
+        // Parse statements until we encounter the end of the program
+        while ( lexer.current().type != lexer::token_type::eof )
+            block->body.push_back( parse_statement() );
+
+        return block;
+    }
+
+    std::unique_ptr< ast::block > parser::create_block()
     {
         std::unique_ptr< ast::block > block = std::make_unique< ast::block >( lexer.current().location );
 
@@ -38,13 +152,21 @@ namespace lorraine::parser
         // Update our last block
         last_block = block.get();
 
-        // Parse statements until we encounter the end of the program
-        while ( lexer.current().type != lexer::token_type::eof )
-            block->body.push_back( parse_statement() );
-
         return block;
     }
 
+    void parser::declare(
+        declaration_kind kind,
+        const std::string& name,
+        std::shared_ptr< ast::type::type > type )
+    {
+        declaration entry{ kind, name, std::move( type ) };
+        entry.apply( last_block );
+
+        if ( journal )
+            journal->push_back( std::move( entry ) );
+    }
+
     std::unique_ptr< ast::statement > parser::parse_statement()
     {
         const auto& current = lexer.current();
@@ -158,7 +280,7 @@ namespace lorraine::parser
         expect( lexer::token_type::sym_rbrace, true );
 
         std::shared_ptr< ast::type::type > type = std::make_shared< ast::type::type >( interface );
-        last_block->export_types.emplace( name.value, type );
+        declare( declaration_kind::export_type, name.value, type );
 
         return std::make_unique< ast::interface_definition >( utils::location{ start, end }, type );
     }
@@ -181,7 +303,7 @@ namespace lorraine::parser
 
         const auto& current = lexer.current();
 
-        std::unique_ptr< ast::module > module = get_module( current.location, current.value );
+        std::shared_ptr< ast::module > module = get_module( current.location, current.value );
         lexer.next();
 
         // Add all identifiers to an expression list
@@ -198,14 +320,15 @@ namespace lorraine::parser
 
                 imports.push_back( std::make_unique< ast::variable_reference >( identifier.location, var ) );
 
-                last_block->variables.emplace( identifier.value, type );
+                declare( declaration_kind::variable, var->value, type );
             }
             // If we are importing a type definition
             else if ( auto type = module->body->get_export_type( name ) )
             {
-                imports.push_back( std::make_unique< ast::type_wrapper >( identifier.location, name, type ) );
+                auto wrapper = std::make_unique< ast::type_wrapper >( identifier.location, name, type );
 
-                last_block->types.emplace( identifier.value, type );
+                declare( declaration_kind::type, wrapper->name, type );
+                imports.push_back( std::move( wrapper ) );
             }
             else
             {
@@ -238,7 +361,7 @@ namespace lorraine::parser
             {
                 std::unique_ptr< ast::type_alias_definition > type_alias = parse_type_alias();
 
-                last_block->export_types.emplace( type_alias->name, type_alias->type );
+                declare( declaration_kind::export_type, type_alias->name, type_alias->type );
 
                 return std::make_unique< ast::export_item >(
                     utils::location{ start, lexer.current().location.end }, std::move( type_alias ) );
@@ -266,7 +389,7 @@ namespace lorraine::parser
                 variable->location, "variable '" + variable->value + "' has already been declared in this scope" );
 
         // Add the variable to the current scope
-        last_block->variables.emplace( variable->value, variable->type );
+        declare( declaration_kind::variable, variable->value, variable->type );
 
         return std::make_unique< ast::external_decleration >(
             utils::location{ start, variable->location.end }, variable );
@@ -291,6 +414,31 @@ namespace lorraine::parser
                     expression = parse_call_expression( std::move( expression ) );
                     continue;
                 }
+                case lexer::token_type::sym_dot:
+                {
+                    lexer.next();
+                    expect( lexer::token_type::identifier );
+
+                    const auto name = lexer.current();
+                    lexer.next();
+
+                    expression = std::make_unique< ast::name_index >(
+                        utils::location{ start, name.location.end }, std::move( expression ), name.value );
+                    continue;
+                }
+                case lexer::token_type::sym_lbracket:
+                {
+                    lexer.next();
+
+                    auto index = parse_expression();
+
+                    const auto end = lexer.current().location.end;
+                    expect( lexer::token_type::sym_rbracket, true );
+
+                    expression = std::make_unique< ast::expression_index >(
+                        utils::location{ start, end }, std::move( expression ), std::move( index ) );
+                    continue;
+                }
             }
 
             // Once we can't identify any more expressions, break out of the loop
@@ -327,15 +475,15 @@ namespace lorraine::parser
             }
             case lexer::token_type::string:
             {
-                // We know that the expression is going to be a string literal but we still call parse_expression for
-                // convenience.
-                std::unique_ptr< ast::expression > expression = parse_expression();
+                // We know that the expression is going to be a string literal but we still call
+                // parse_simple_expression for convenience. The call only takes the literal, not an operation on it.
+                std::unique_ptr< ast::expression > expression = parse_simple_expression();
+                const auto location = expression->location;
 
                 ast::expression_list arguments;
                 arguments.push_back( std::move( expression ) );
 
-                return std::make_unique< ast::call >(
-                    expression->location, std::move( function ), std::move( arguments ) );
+                return std::make_unique< ast::call >( location, std::move( function ), std::move( arguments ) );
             }
         }
 
@@ -381,7 +529,7 @@ namespace lorraine::parser
 
         // Create our type descriptor and add it to the current scope
         auto descriptor = std::make_shared< ast::type::type >( ast::type::descriptor::function{ arguments, returns } );
-        last_block->variables.emplace( name, descriptor );
+        declare( declaration_kind::variable, name, descriptor );
 
         const auto end = lexer.current().location.end;
 
@@ -408,13 +556,22 @@ namespace lorraine::parser
         return identifiers;
     }
 
-    std::unique_ptr< ast::module > parser::get_module( const utils::location& loc, const std::string& name )
+    std::shared_ptr< ast::module > parser::get_module( const utils::location& loc, const std::string& name )
     {
         std::shared_ptr< ast::module::information > info = ast::module::get_information( this->info, name );
 
         if ( !info )
             throw utils::syntax_error( loc, "There was an issue parsing the module name. Use './' for local files." );
 
+        // Every module is only parsed once for all modules that import it, until its file changes
+        return compiler->get_shared_module( info->absolute(), [ & ]() { return load_module( loc, name, info ); } );
+    }
+
+    std::unique_ptr< ast::module > parser::load_module(
+        const utils::location& loc,
+        const std::string& name,
+        std::shared_ptr< ast::module::information > info )
+    {
         // Check if module actually exists
         auto source = utils::io::read_file( info->absolute() );
 
@@ -426,12 +583,33 @@ namespace lorraine::parser
             throw utils::syntax_error( loc, msg.str() );
         }
 
-        // Set the source of the module
-        info->source = source.value();
+        // The module keeps its source alive, the AST references it
+        info->buffer = std::move( *source );
+        info->source = info->buffer;
 
-        parser parser{ info, *source, compiler };
+        std::unique_ptr< ast::module > module;
 
-        return parser.parse();
+        // The lexer reads the first token as it is created, the errors of the module are reported like its parser does
+        try
+        {
+            parser parser{ info, info->source, compiler };
+            module = parser.parse();
+        }
+        catch ( const utils::syntax_error& e )
+        {
+            compiler->llvm_display_error( info->absolute(), info->source, e );
+        }
+
+        // The error itself has already been reported by the parser of the module
+        if ( !module )
+        {
+            std::stringstream msg;
+            msg << "unable to parse module '" << name << "'";
+
+            throw utils::syntax_error( loc, msg.str() );
+        }
+
+        return module;
     }
 
     ast::type::type_list parser::get_type_list( ast::expression_list expressions )
@@ -473,7 +651,7 @@ namespace lorraine::parser
 
         std::shared_ptr< ast::type::type > type = parse_type();
 
-        last_block->types.emplace( name, type );
+        declare( declaration_kind::type, name, type );
 
         return std::make_unique< ast::type_alias_definition >(
             utils::location{ start, lexer.current().location.end }, name, type );
@@ -686,6 +864,27 @@ namespace lorraine::parser
             throw utils::syntax_error( current.location, msg.str() );
         }
 
+        // Generic interfaces can be given the types of their generics, like 'Array<number>'
+        if ( auto interface = std::get_if< ast::type::descriptor::interface >( &type->value );
+             interface && !interface->generics.empty() && lexer.current().type == lexer::token_type::sym_l )
+        {
+            const auto location = lexer.current().location;
+            lexer.next();
+
+            interface->arguments = parse_type_list();
+
+            if ( interface->arguments.size() != interface->generics.size() )
+            {
+                std::stringstream msg;
+                msg << "the type '" << current.value << "' expects " << interface->generics.size()
+                    << " type arguments, got " << interface->arguments.size();
+
+                throw utils::syntax_error( location, msg.str() );
+            }
+
+            expect( lexer::token_type::sym_g, true );
+        }
+
         // If we have a '[' following the named type, then we must have an array type;
         if ( lexer.current().type == lexer::token_type::sym_lbracket )
         {
@@ -726,7 +925,8 @@ namespace lorraine::parser
         // Note: doing this so that the formatter doesn't multiline
         auto& types = block->types;
 
-        // Add the array type. It is an interface with one generic type.
+        // Add the array type. It is an interface with one generic type. The type definitions are the same for every
+        // module, so they are only parsed once per session.
         std::shared_ptr< ast::module > array_module = get_module( utils::location{}, array_module_name );
 
         if ( const auto array = array_module->body->get_export_type( "Array" ) )
@@ -752,7 +952,7 @@ namespace lorraine::parser
         else
             expect( lexer::token_type::identifier );
 
-        const auto& name = lexer.current().value;
+        const auto name = lexer.current().value;
 
         lexer.next();
 
@@ -804,32 +1004,56 @@ namespace lorraine::parser
 
     std::unique_ptr< ast::expression > parser::parse_expression()
     {
-        const auto current = lexer.current();
-        const auto start = current.location.start;
+        return parse_binary_expression( 0 );
+    }
 
-        switch ( current.type )
+    std::unique_ptr< ast::expression > parser::parse_binary_expression( unsigned limit )
+    {
+        const auto start = lexer.current().location.start;
+
+        std::unique_ptr< ast::expression > expression;
+
+        if ( const auto op = get_unary_operator( lexer.current().type ) )
         {
-            case lexer::token_type::number:
-            {
-                double value;
+            lexer.next();
 
-                const std::string data = std::string{ current.value };
+            std::unique_ptr< ast::expression > value = parse_binary_expression( unary_priority );
+            const auto end = value->location.end;
 
-                try
-                {
-                    value = std::stod( data );
-                }
-                catch ( const std::invalid_argument& e )
-                {
-                    std::stringstream message;
-                    message << "Unable to convert '" << data << "' to a number";
+            expression =
+                std::make_unique< ast::unary_expression >( utils::location{ start, end }, *op, std::move( value ) );
+        }
+        else
+            expression = parse_simple_expression();
 
-                    throw utils::syntax_error( utils::location{ start, lexer.current().location.end }, message.str() );
-                }
+        // Operators that bind tighter than the limit take the expression as their left operand
+        for ( auto op = get_binary_operator( lexer.current().type ); op && get_priority( *op ).left > limit;
+              op = get_binary_operator( lexer.current().type ) )
+        {
+            lexer.next();
 
+            std::unique_ptr< ast::expression > right = parse_binary_expression( get_priority( *op ).right );
+            const auto end = right->location.end;
+
+            expression = std::make_unique< ast::binary_expression >(
+                utils::location{ start, end }, *op, std::move( expression ), std::move( right ) );
+        }
+
+        return expression;
+    }
+
+    std::unique_ptr< ast::expression > parser::parse_simple_expression()
+    {
+        const auto current = lexer.current();
+
+        switch ( current.type )
+        {
+            case lexer::token_type::number:
+            {
+                // The lexer already converted the number
                 lexer.next();
 
-                return std::make_unique< ast::number_literal >( current.location, value );
+                return std::make_unique< ast::number_literal >( current.location, current.number, current.integer );
             }
             case lexer::token_type::string:
             {
@@ -860,6 +1084,11 @@ namespace lorraine::parser
             {
                 return parse_list_constructor();
             }
+            case lexer::token_type::identifier:
+            case lexer::token_type::sym_lparen:
+            {
+                return parse_primary_expression();
+            }
 
             default:
             {
@@ -933,16 +1162,22 @@ namespace lorraine::parser
 
         expect( lexer::token_type::kw_local, true );
 
+        const bool constant = lexer.current().type == lexer::token_type::kw_const;
+
+        if ( constant )
+            lexer.next();
+
         ast::variable_list variables = parse_variable_list();
 
-        last_block->load_variable_list( variables );
+        for ( const auto& variable : variables )
+            declare( declaration_kind::variable, variable->value, variable->type );
 
         expect( lexer::token_type::sym_equals, true );
 
         ast::expression_list expressions = parse_expression_list();
 
         return std::make_unique< ast::local_assignment >(
-            utils::location{ start, lexer.current().location.end }, variables, std::move( expressions ) );
+            utils::location{ start, lexer.current().location.end }, variables, std::move( expressions ), constant );
     }
 
     void parser::expect( const lexer::token_type type, const bool consume )
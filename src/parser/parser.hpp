@@ -7,13 +7,32 @@
 
 namespace lorraine::parser
 {
+    enum class declaration_kind
+    {
+        variable,
+        type,
+        export_type
+    };
+
+    /// @brief A name a statement added to the block it was parsed in
+    struct declaration
+    {
+        declaration_kind kind;
+        std::string name;
+        std::shared_ptr< ast::type::type > type;
+
+        /// @brief Adds the name to a block, unless the block already has it
+        /// @param block The block
+        void apply( ast::block* block ) const;
+    };
+
     class parser final
     {
        public:
         /// @brief Initializes a new parser class instance
         explicit parser( const std::string& name, const std::string_view& source, compiler::compiler* compiler )
             : source( source ),
-              lexer( source, compiler ),
+              lexer( source, compiler, source.size() >= lexer::lexer::pipeline_threshold ),
               compiler( compiler )
         {
             info = ast::module::information::get( name, source );
@@ -25,7 +44,25 @@ namespace lorraine::parser
             const std::string_view& source,
             compiler::compiler* compiler )
             : source( source ),
-              lexer( source, compiler ),
+              lexer( source, compiler, source.size() >= lexer::lexer::pipeline_threshold ),
+              compiler( compiler ),
+              info( info )
+        {
+        }
+
+        /// @brief Initializes a new parser class instance that parses tokens that were already tokenized
+        /// @param info The module the tokens belong to
+        /// @param tokens The tokens, ending with the end of file or an error
+        /// @param position Position of the first token to parse
+        /// @param error The error tokenizing failed with, if the tokens end with it
+        explicit parser(
+            std::shared_ptr< ast::module::information > info,
+            const std::vector< lexer::token >& tokens,
+            std::size_t position,
+            compiler::compiler* compiler,
+            const utils::syntax_error* error = nullptr )
+            : source( info->source ),
+              lexer( tokens, position, compiler, error ),
               compiler( compiler ),
               info( info )
         {
@@ -35,7 +72,19 @@ namespace lorraine::parser
         /// @return A new block
         std::unique_ptr< ast::module > parse();
 
+        /// @brief Creates the module for parsing the source one top-level statement at a time (see parse_next).
+        /// The body of the module stays empty, only its scope (variables and types) outlives the statements.
+        /// @return The module or nullptr if an error was reported
+        std::unique_ptr< ast::module > parse_module_scope();
+
+        /// @brief Parses the next top-level statement of the module created by parse_module_scope
+        /// @param statement Set to the statement, or to nullptr at the end of the source
+        /// @return False if a syntax error was reported
+        bool parse_next( std::unique_ptr< ast::statement >& statement );
+
        private:
+        friend class document;
+
         lexer::lexer lexer;
         compiler::compiler* compiler;
 
@@ -45,6 +94,9 @@ namespace lorraine::parser
         /// @brief Last block created and entered. Type and variable definitions will get added.
         ast::block* last_block = nullptr;
 
+        /// @brief Declarations of the statement being parsed are recorded here, if set (see document)
+        std::vector< declaration >* journal = nullptr;
+
         /// @brief  Basic 'any' type. Used for unresolved types or when none are specified. This is
         /// also a member variable for convenience, as a type instance of 'any' is commonly
         /// referenced in the code.
@@ -65,11 +117,22 @@ namespace lorraine::parser
         /// @param consume Tells the function to consume the following token
         void expect( const lexer::token_type type, const bool consume = false );
 
+        /// @brief Gets an imported module, parsing it if it was not parsed in this session or its file changed since
+        /// (see compiler::get_shared_module)
+        /// @param loc The location of the import statement invoking this function
+        /// @param name The module name
+        /// @return The module
+        std::shared_ptr< ast::module > get_module( const utils::location& loc, const std::string& name );
+
         /// @brief Opens a new module and parses it into an AST
         /// @param loc The location of the import statement invoking this function
         /// @param name The module name
+        /// @param info The module
         /// @return The new module
-        std::unique_ptr< ast::module > get_module( const utils::location& loc, const std::string& name );
+        std::unique_ptr< ast::module > load_module(
+            const utils::location& loc,
+            const std::string& name,
+            std::shared_ptr< ast::module::information > info );
 
         /// @brief Creates a type list from the types referenced in an expression list
         /// @param expressions The expression list
@@ -85,6 +148,16 @@ namespace lorraine::parser
         /// @return New block
         std::unique_ptr< ast::block > parse_block();
 
+        /// @brief Creates a new block and enters it
+        /// @return New block without statements
+        std::unique_ptr< ast::block > create_block();
+
+        /// @brief Adds a name to the current block and records it in the journal
+        /// @param kind What the name is declared as
+        /// @param name The name
+        /// @param type Its type
+        void declare( declaration_kind kind, const std::string& name, std::shared_ptr< ast::type::type > type );
+
         /// @brief Registers all primitive types to a block
         /// @param block Our block
         void register_primitives( ast::block* block );
@@ -101,6 +174,15 @@ namespace lorraine::parser
         /// @return Expression
         std::unique_ptr< ast::expression > parse_expression();
 
+        /// @brief Parses an expression with operators, as long as they bind tighter than a limit (see Lua's subexpr)
+        /// @param limit Priority an operator has to exceed
+        /// @return Expression
+        std::unique_ptr< ast::expression > parse_binary_expression( unsigned limit );
+
+        /// @brief Parses an expression without operators: a literal, constructor or primary expression
+        /// @return Expression
+        std::unique_ptr< ast::expression > parse_simple_expression();
+
         /// @brief Parses a list of expressions seperated by a comma (',')
         /// @return Expression list
         ast::expression_list parse_expression_list();
@@ -0,0 +1,10 @@
+extern printf: (string, ...any) => number
+
+local primes: number[] = { 2, 3, 5, 7, 11 }
+
+printf("%g primes, the last is %g\n", primes.length, primes[#primes])
+
+-- Lengths are integers, but zero times a negative number is still negative zero
+local none: number = #primes - 5
+
+printf("%g %g %g\n", none * -1, ( none - 4 ) % 2, 1 / -none)
@@ -0,0 +1,14 @@
+extern printf: (string, ...any) => number
+
+local const name: string = "world"
+local const width: number = 2 ^ 4 * 3 - 1
+
+printf("Hello, " .. name .. "! %g %d\n", width, width > 40 and not false)
+
+-- Strings only known at run time are not folded
+extern strstr: (string, string) => string
+
+printf("%s %d %d\n", strstr("hello world", "wor") .. "!", strstr("hello world", "wor") == name, strstr("ab", "b") < "a")
+
+-- Negative zero, folded like the double arithmetic computes it
+printf("%g %g\n", 1 / -0, 1 / ( 0 * -1 ))
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "../src/ast/visitor.hpp"
+#include "../src/compiler/compiler.hpp"
+#include "../src/parser/document.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check( bool condition, const std::string& message )
+    {
+        if ( !condition )
+        {
+            std::cerr << "FAILED: " << message << '\n';
+            ++failures;
+        }
+    }
+
+    /// @brief Writes every node of a module with its location, and the names in the scope of the module
+    struct dumper final : lorraine::ast::visitor
+    {
+        using lorraine::ast::visitor::visit;
+
+        std::ostringstream out;
+
+        void write( const lorraine::utils::location& location )
+        {
+            out << location.start.line << ':' << location.start.column << '-' << location.end.line << ':'
+                << location.end.column << ' ';
+        }
+
+        bool visit( lorraine::ast::node* node ) override
+        {
+            out << typeid( *node ).name() << ' ';
+            write( node->location );
+            out << '\n';
+
+            return true;
+        }
+
+        bool visit( lorraine::ast::variable_reference* node ) override
+        {
+            write( node->var->location );
+            out << node->var->value << ' ';
+
+            return visit( static_cast< lorraine::ast::node* >( node ) );
+        }
+
+        bool visit( lorraine::ast::local_assignment* node ) override
+        {
+            for ( const auto& variable : node->variables )
+            {
+                write( variable->location );
+                out << variable->value << ' ' << variable->type->to_string() << ' ';
+            }
+
+            return visit( static_cast< lorraine::ast::node* >( node ) );
+        }
+
+        bool visit( lorraine::ast::module* ) override
+        {
+            return false;
+        }
+    };
+
+    std::string dump( lorraine::ast::module& module )
+    {
+        dumper d;
+
+        for ( const auto& statement : module.body->body )
+            statement->visit( &d );
+
+        std::vector< std::string > names;
+
+        for ( const auto& [ name, type ] : module.body->variables )
+            names.push_back( "variable " + name + ' ' + type->to_string() );
+
+        for ( const auto& [ name, type ] : module.body->types )
+            names.push_back( "type " + name );
+
+        for ( const auto& [ name, type ] : module.body->export_types )
+            names.push_back( "export " + name );
+
+        std::sort( names.begin(), names.end() );
+
+        for ( const auto& name : names )
+            d.out << name << '\n';
+
+        return d.out.str();
+    }
+
+    std::string dump( const std::vector< lorraine::lexer::token >& tokens )
+    {
+        using lorraine::lexer::token_type;
+
+        std::ostringstream out;
+
+        for ( const auto& token : tokens )
+        {
+            // Only names and literals have a value
+            const bool value = token.type == token_type::identifier || token.type == token_type::string ||
+                               token.type == token_type::number;
+
+            out << static_cast< int >( token.type ) << ' ' << ( value ? token.value : "" ) << ' '
+                << token.location.start.line << ':' << token.location.start.column << '-' << token.location.end.line
+                << ':' << token.location.end.column << '\n';
+        }
+
+        return out.str();
+    }
+
+    /// @brief Applies edits to a document and compares it with a full parse of its new source
+    /// @return True if the edits left the source without syntax errors
+    bool compare(
+        lorraine::compiler::compiler& compiler,
+        lorraine::parser::document& document,
+        const std::vector< lorraine::parser::text_edit >& edits,
+        const std::string& description )
+    {
+        const bool applied = document.apply( edits );
+
+        std::unique_ptr< lorraine::ast::module > full;
+
+        try
+        {
+            full = compiler.parse( "document.lua", document.get_source() );
+        }
+        catch ( const lorraine::utils::syntax_error& )
+        {
+        }
+
+        check( applied == ( full != nullptr ), description + ": the edit and a full parse agree on errors" );
+
+        if ( applied && full )
+        {
+            check( dump( document.get_module() ) == dump( *full ), description + ": the syntax trees are the same" );
+
+            lorraine::lexer::lexer lexer{ document.get_source(), &compiler, false };
+            std::vector< lorraine::lexer::token > tokens{ lexer.current() };
+
+            while ( tokens.back().type != lorraine::lexer::token_type::eof )
+            {
+                lexer.next();
+                tokens.push_back( lexer.current() );
+            }
+
+            check( dump( document.get_tokens() ) == dump( tokens ), description + ": the tokens are the same" );
+        }
+
+        return applied;
+    }
+}  // namespace
+
+int main()
+{
+    using namespace lorraine;
+
+    const std::string source =
+        "extern printf: (string, ...any) => number\n"
+        "\n"
+        "local a: number = 1\n"
+        "printf(\"Hello, %s!\\n\", \"world\")\n"
+        "type T = { n: number }\n"
+        "local b: T = { n = 2 }\n"
+        "-- comment\n"
+        "printf(\"%g\\n\", 3)\n"
+        "local c: string = \"c\"\n";
+
+    // The type definitions of the source tree, the test does not depend on where it is run from
+    cli::config cfg;
+    cfg.get< std::string >( "pathToTypeDefinitions" ) = LORRAINE_TYPE_DEFINITIONS;
+
+    compiler::compiler compiler{ cfg };
+
+    auto document = parser::document::open( "document.lua", source, &compiler );
+    check( document && document->is_complete(), "the document opens" );
+
+    if ( !document )
+        return 1;
+
+    const auto offset = [ & ]( const std::string& text ) { return document->get_source().find( text ); };
+
+    // An edit inside a statement only parses that statement again
+    compare( compiler, *document, { { offset( "= 1" ) + 2, 1, "42" } }, "changing a number" );
+    check( document->get_parsed().size() == 1, "only the changed statement is parsed again" );
+
+    // Statements that are added, moved or removed move the lines of the statements after them
+    compare( compiler, *document, { { offset( "type T" ), 0, "printf(\"new\")\n" } }, "adding a statement" );
+    compare( compiler, *document, { { offset( "printf(\"new\")" ), 14, "" } }, "removing a statement" );
+    compare( compiler, *document, { { offset( "\", \"world" ) + 2, 0, "\n" } }, "breaking a line" );
+
+    // Declaring different names parses the statements that may refer to them again
+    compare( compiler, *document, { { offset( "type T" ) + 5, 1, "U" } }, "renaming a type that is used" );
+    compare( compiler, *document, { { offset( "type U" ) + 5, 1, "T" } }, "renaming it back" );
+
+    // Comments and strings change where tokens start
+    compare( compiler, *document, { { offset( "-- comment" ) + 3, 0, "longer " } }, "extending a comment" );
+    compare( compiler, *document, { { offset( "local c" ), 0, "-- " } }, "commenting out a statement" );
+    compare( compiler, *document, { { offset( "-- local c" ), 3, "" } }, "uncommenting it" );
+
+    // A syntax error keeps the statements before it, fixing it parses everything again
+    check(
+        !compare( compiler, *document, { { offset( "local b" ), 0, "local = \n" } }, "adding a syntax error" ),
+        "the syntax error is reported" );
+    check( !document->is_complete(), "the document is incomplete after a syntax error" );
+    compare( compiler, *document, { { offset( "local = \n" ), 9, "" } }, "fixing the syntax error" );
+    check( document->is_complete(), "the document is complete again" );
+
+    // Random edits of a few characters, most of which are syntax errors for a while
+    const std::vector< std::string > snippets{
+        "x", " ", "\n", "local y = 1\n", "\"", "--", "[[", "]]", "(", ")", "1", "printf(\"a\")\n", "type Q = number\n",
+        "local q: T = { n = 3 }\n", "{", "}", ",", "=", ".", "..", "--[[ c\n", "\nlocal z: string = \"s\"\n" };
+
+    std::mt19937 random( 1 );
+
+    for ( int round = 0; round < 200; ++round )
+    {
+        std::vector< parser::text_edit > edits;
+        std::string edited = document->get_source();
+
+        for ( std::size_t count = 1 + random() % 2; edits.size() < count; )
+        {
+            parser::text_edit edit;
+            edit.offset = random() % ( edited.size() + 1 );
+            edit.length = random() % 3 == 0 ? std::min< std::size_t >( random() % 12, edited.size() - edit.offset ) : 0;
+            edit.text = random() % 4 == 0 ? "" : snippets[ random() % snippets.size() ];
+
+            edited.replace( edit.offset, edit.length, edit.text );
+            edits.push_back( edit );
+        }
+
+        compare( compiler, *document, edits, "random edit " + std::to_string( round ) );
+
+        // Starts over every now and then, so the source does not end up as nothing but syntax errors
+        if ( round % 25 == 24 )
+            document->apply( { { 0, document->get_source().size(), source } } );
+    }
+
+    return failures == 0 ? 0 : 1;
+}
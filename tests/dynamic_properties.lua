@@ -0,0 +1,39 @@
+extern printf: (string, ...any) => number
+
+type Point = { x: number, y: number, label?: string }
+type Named = { label: string, x: number }
+
+local p: Point = { x = 3, y = 4 }
+local n: Named = { label = "n", x = 1 }
+
+local a: any = p
+local b: any = n
+
+local x: number = a.x
+local label: string = b.label
+local key = "y"
+local y: number = a[ key ]
+
+printf("%f %f %s %d\n", x, y, label, a.label == nil)
+
+-- Boxes are opened for variadic functions: the number is passed as a double, the string as its pointer
+printf("%f %s\n", a.x, b.label)
+
+-- Values of type any are taken out of their box where a primitive is expected, like the elements of this array
+local coordinates: number[] = { a.x, a.y }
+
+printf("%s\n", coordinates.toString())
+
+-- An index of type any is taken out of its box as well
+printf("%f\n", coordinates[ b.x ])
+
+-- The conversions of a constant format open each box on its own, however many there are
+printf("%g %g %s %g %.1f %d\n", a.x, a.y, b.label, b.x, a.x, b.x)
+
+-- A property of type any takes a value of any type, it is boxed in the table
+type Box = { content: any }
+
+local boxed: Box = { content = 3 }
+local unboxed: number = boxed.content
+
+printf("%g\n", unboxed + 1)
@@ -0,0 +1,23 @@
+extern printf: (string, ...any) => number
+
+local numbers: number[] = { 1, 2.5, 3 }
+local names: string[] = { "a", "b" }
+
+-- Both arrays implement the Array interface
+local a: Array = numbers
+local b: Array = names
+
+printf("%s %s\n", numbers.toString(), names.toString())
+printf("%s %f %s %f\n", a.toString(), a.length, b.toString(), b.length)
+
+-- The type of the elements can be given, arrays of other elements do not fit then. Arrays of elements that cannot be
+-- converted to strings implement the interface as well.
+type Point = { x: number }
+
+local point: Point = { x = 1 }
+local points: Point[] = { point, point }
+
+local c: Array<number> = numbers
+local d: Array = points
+
+printf("%s %f\n", c.toString(), d.length)
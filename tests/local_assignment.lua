@@ -1 +1,6 @@
-local a: nil = nil
\ No newline at end of file
+local a: nil = nil
+
+-- A property of type any takes a value of any type, it is boxed in the table
+type Box = { content: any }
+
+local boxed: Box = { content = 3 }
\ No newline at end of file
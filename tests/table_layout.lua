@@ -0,0 +1,21 @@
+extern printf: (string, ...any) => number
+
+type Point = {
+    visible: boolean,
+    x: number,
+    label?: string,
+    y: number
+}
+
+local origin: Point = { x = 0, y = 0, visible = true }
+local p: Point = { x = 3, y = 4, visible = false, label = "p" }
+
+printf("%f %f\n", p.x - origin.x, p.y - origin.y)
+
+-- Assigned to a type with fewer properties, the table is copied to the layout of that type
+type Position = { y: number, label?: string }
+
+local position: Position = p
+local label: string = position.label
+
+printf("%f %s\n", position.y, label)
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../src/build/build.hpp"
+#include "../src/compiler/compiler.hpp"
+
+namespace
+{
+    int failures = 0;
+
+    void check( bool condition, const std::string& message )
+    {
+        if ( !condition )
+        {
+            std::cerr << "FAILED: " << message << '\n';
+            ++failures;
+        }
+    }
+
+    void write( const std::filesystem::path& path, const std::string& source )
+    {
+        // The modification time has to change even if the file is written twice within its resolution
+        const bool existed = std::filesystem::exists( path );
+        const auto modified = existed ? std::filesystem::last_write_time( path ) : std::filesystem::file_time_type{};
+
+        std::ofstream( path ) << source;
+
+        if ( existed )
+            std::filesystem::last_write_time( path, modified + std::chrono::seconds( 1 ) );
+    }
+}  // namespace
+
+int main()
+{
+    using namespace lorraine;
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    const auto root = std::filesystem::temp_directory_path() / ( "lorraine-watch-test-" + std::to_string( now ) );
+    std::filesystem::create_directories( root );
+
+    // c imports a type of b, which is made of a type of a. Only a changes.
+    write( root / "a.lua", "export type T = { v: number }\n" );
+    write( root / "b.lua", "import { T } from './a'\nexport type U = { t: T }\n" );
+    write( root / "c.lua", "import { U } from './b'\nlocal u: U = { t = { v = 1 } }\n" );
+
+    // The type definitions of the source tree, the test does not depend on where it is run from
+    cli::config cfg;
+    cfg.get< std::string >( "pathToTypeDefinitions" ) = LORRAINE_TYPE_DEFINITIONS;
+
+    auto shared = std::make_shared< compiler::session >();
+
+    {
+        // Like the watcher, the project keeps its compiler (and the modules it shares) between updates
+        compiler::compiler compiler{ cfg, shared };
+        build::project project{ compiler, root, root / "build", compiler::compiler_stage::type };
+
+        check( project.build() == 0, "the project builds" );
+
+        write( root / "a.lua", "export type T = { w: string }\n" );
+        check( project.update( { root / "a.lua" } ) != 0, "c.lua is checked against the changed type of a.lua" );
+
+        write( root / "a.lua", "export type T = { v: number }\n" );
+        check( project.update( { root / "a.lua" } ) == 0, "c.lua builds again once a.lua is restored" );
+    }
+
+    std::filesystem::remove_all( root );
+
+    return failures == 0 ? 0 : 1;
+}